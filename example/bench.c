@@ -0,0 +1,803 @@
+// NOTE(Caleb): recvmmsg and sendmmsg are GNU extensions
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cstruct.h"
+
+#define GAME_PACKET_HEADER_FORMAT "!HBBIIHBx16s3f3hBB"
+#define GAME_PACKET_SIZE          52
+#define GAME_PACKET_MAGIC         0xB00B
+#define GAME_PACKET_REQUEST       0x05
+#define GAME_PACKET_REPLY         0x06
+
+/// The number of messages sent or received by a single system call, which is also the number of
+/// messages each client keeps in flight.
+#define BENCH_BATCH_SIZE 64
+
+/// How long a client waits for the rest of a batch before counting it as lost, in milliseconds.
+#define BENCH_TIMEOUT_MS 100
+
+/// The number of linear sub-buckets per power of two in a latency histogram.
+#define BENCH_HISTOGRAM_SUB_BITS 4
+#define BENCH_HISTOGRAM_SIZE     (64 << BENCH_HISTOGRAM_SUB_BITS)
+
+typedef struct
+{
+    uint16_t magic;
+    uint8_t  version;
+    uint8_t  packet_type;
+    uint32_t sequence_num;
+    uint32_t timestamp;
+    uint16_t payload_length;
+    uint8_t  flags;
+    uint8_t  reserved;
+    char     session_id[16];
+    float    position[3];
+    int16_t  rotation[3];
+    uint8_t  health;
+    uint8_t  checksum;
+} game_packet_header_t;
+
+/// A log-linear latency histogram, accurate to within 1/16th of each value.
+typedef struct
+{
+    uint64_t counts[BENCH_HISTOGRAM_SIZE];
+    uint64_t total;
+} histogram_t;
+
+/// What a single thread measured.
+typedef struct
+{
+    histogram_t latency;
+    uint64_t    received;
+    uint64_t    lost;
+    uint64_t    cstruct_ns;
+} stats_t;
+
+/// A client thread.
+typedef struct
+{
+    pthread_t          thread;
+    bool               tcp;
+    struct sockaddr_in server;
+    uint32_t           id;
+    stats_t            stats;
+} client_t;
+
+/// The server thread.
+typedef struct
+{
+    pthread_t thread;
+    bool      tcp;
+    int       fd;
+    stats_t   stats;
+} server_t;
+
+/// A TCP connection to the server.
+typedef struct
+{
+    int     fd;
+    size_t  in_size;
+    size_t  out_size;
+    uint8_t in[BENCH_BATCH_SIZE * GAME_PACKET_SIZE * 2];
+    uint8_t out[BENCH_BATCH_SIZE * GAME_PACKET_SIZE * 4];
+} connection_t;
+
+static atomic_bool __bench_running = true;
+static atomic_bool __bench_serving = true;
+
+static uint64_t __bench_now(void);
+static uint64_t __bench_cpu_now(void);
+static ssize_t  __bench_pack(const game_packet_header_t *header, uint8_t *buffer);
+static ssize_t  __bench_unpack(const uint8_t *buffer, game_packet_header_t *header);
+static size_t   __bench_histogram_index(uint64_t value);
+static uint64_t __bench_histogram_value(size_t index);
+static void     __bench_histogram_add(histogram_t *histogram, uint64_t value);
+static void     __bench_histogram_merge(histogram_t *histogram, const histogram_t *other);
+static uint64_t __bench_histogram_percentile(const histogram_t *histogram, double percentile);
+static size_t   __bench_serve_messages(
+    stats_t *stats, const uint8_t *in, size_t size, uint8_t *out);
+static int      __bench_flush(connection_t *connection);
+static void    *__bench_udp_server(server_t *server);
+static void    *__bench_tcp_server(server_t *server);
+static void    *__bench_server(void *arg);
+static void    *__bench_client(void *arg);
+
+static const game_packet_header_t template_packet_header = {
+    .magic          = GAME_PACKET_MAGIC,
+    .version        = 0x02,
+    .packet_type    = GAME_PACKET_REQUEST,
+    .sequence_num   = 0,
+    .timestamp      = 1620000000,
+    .payload_length = 512,
+    .flags          = 0x0A,
+    .reserved       = 0x00,
+    .session_id     = "ABCD1234EFGH5678",
+    .position       = {128.5f, -42.75f, 1024.0f},
+    .rotation       = {45, 180, -30},
+    .health         = 75,
+    .checksum       = 0xCC,
+};
+
+int main(int argc, char **argv)
+{
+    bool     tcp     = argc > 1 && strcmp(argv[1], "tcp") == 0;
+    long     threads = argc > 2 ? strtol(argv[2], NULL, 10) : 4;
+    double   seconds = argc > 3 ? strtod(argv[3], NULL) : 5.0;
+    uint64_t start   = 0;
+    uint64_t end     = 0;
+
+    // NOTE(Caleb): The top byte of each sequence number holds the client which sent it
+    if ((argc > 1 && !tcp && strcmp(argv[1], "udp") != 0) || threads < 1 || threads > 256
+        || seconds <= 0)
+    {
+        fprintf(stderr, "usage: %s [udp|tcp] [client threads] [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    if (cstruct_sizeof(GAME_PACKET_HEADER_FORMAT) != GAME_PACKET_SIZE)
+    {
+        fprintf(stderr, "unexpected packet size\n");
+        return 1;
+    }
+
+    server_t server = {.tcp = tcp};
+    server.fd       = socket(AF_INET, tcp ? SOCK_STREAM : SOCK_DGRAM, 0);
+
+    // NOTE(Caleb): Bind to any free loopback port, and point the clients at it
+    struct sockaddr_in address = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    socklen_t          address_size = sizeof(address);
+
+    if (server.fd < 0 || bind(server.fd, (struct sockaddr *)&address, sizeof(address)) < 0
+        || getsockname(server.fd, (struct sockaddr *)&address, &address_size) < 0
+        || (tcp && listen(server.fd, (int)threads) < 0))
+    {
+        perror("server");
+        return 1;
+    }
+
+    client_t *clients = calloc(threads, sizeof(client_t));
+    if (!clients || pthread_create(&server.thread, NULL, __bench_server, &server) != 0)
+    {
+        perror("server");
+        return 1;
+    }
+
+    start = __bench_now();
+
+    for (long i = 0; i < threads; i++)
+    {
+        clients[i].tcp    = tcp;
+        clients[i].server = address;
+        clients[i].id     = (uint32_t)i;
+
+        if (pthread_create(&clients[i].thread, NULL, __bench_client, &clients[i]) != 0)
+        {
+            perror("client");
+            return 1;
+        }
+    }
+
+    struct timespec duration = {
+        .tv_sec  = (time_t)seconds,
+        .tv_nsec = (long)((seconds - (time_t)seconds) * 1e9),
+    };
+    nanosleep(&duration, NULL);
+
+    atomic_store(&__bench_running, false);
+    end = __bench_now();
+
+    // NOTE(Caleb): The server keeps answering until every client has collected its last batch
+    stats_t total = {0};
+    for (long i = 0; i < threads; i++)
+    {
+        pthread_join(clients[i].thread, NULL);
+
+        __bench_histogram_merge(&total.latency, &clients[i].stats.latency);
+        total.received += clients[i].stats.received;
+        total.lost += clients[i].stats.lost;
+        total.cstruct_ns += clients[i].stats.cstruct_ns;
+    }
+
+    atomic_store(&__bench_serving, false);
+    pthread_join(server.thread, NULL);
+    total.cstruct_ns += server.stats.cstruct_ns;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    double elapsed = (double)(end - start) / 1e9;
+    double cpu     = (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec / 1e6
+               + (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec / 1e6;
+
+    printf("%s, %ld client threads, %.1f s\n", tcp ? "tcp" : "udp", threads, elapsed);
+    printf(
+        "messages:   %llu round trips (%.0f/s), %llu lost\n",
+        (unsigned long long)total.received,
+        (double)total.received / elapsed,
+        (unsigned long long)total.lost);
+    printf(
+        "latency:    p50 %.1f us, p99 %.1f us, p999 %.1f us\n",
+        (double)__bench_histogram_percentile(&total.latency, 0.5) / 1e3,
+        (double)__bench_histogram_percentile(&total.latency, 0.99) / 1e3,
+        (double)__bench_histogram_percentile(&total.latency, 0.999) / 1e3);
+    printf(
+        "cpu:        %.2f s, of which %.2f s (%.1f%%) in cstruct\n",
+        cpu,
+        (double)total.cstruct_ns / 1e9,
+        cpu > 0 ? (double)total.cstruct_ns / 1e7 / cpu : 0.0);
+
+    close(server.fd);
+    free(clients);
+
+    return 0;
+}
+
+// Private Helpers ---------------------------------------------------------------------------------
+
+/// Return the time of a monotonic clock.
+/// @return The time, in nanoseconds.
+static uint64_t __bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+/// Return the CPU time used by the calling thread, which unlike __bench_now excludes any time the
+/// thread was not scheduled.
+/// @return The time, in nanoseconds.
+static uint64_t __bench_cpu_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+/// Pack a game packet header.
+/// @param[in] header The header.
+/// @param[out] buffer The buffer, which must hold GAME_PACKET_SIZE bytes.
+/// @return The number of bytes packed, or -1 if an error occurred.
+static ssize_t __bench_pack(const game_packet_header_t *header, uint8_t *buffer)
+{
+    return cstruct_pack(
+        GAME_PACKET_HEADER_FORMAT,
+        buffer,
+        GAME_PACKET_SIZE,
+        header->magic,
+        header->version,
+        header->packet_type,
+        header->sequence_num,
+        header->timestamp,
+        header->payload_length,
+        header->flags,
+        header->session_id,
+        header->position[0],
+        header->position[1],
+        header->position[2],
+        header->rotation[0],
+        header->rotation[1],
+        header->rotation[2],
+        header->health,
+        header->checksum);
+}
+
+/// Unpack a game packet header.
+/// @param[in] buffer The buffer, which must hold GAME_PACKET_SIZE bytes.
+/// @param[out] header The header.
+/// @return The number of bytes unpacked, or -1 if an error occurred.
+static ssize_t __bench_unpack(const uint8_t *buffer, game_packet_header_t *header)
+{
+    return cstruct_unpack(
+        GAME_PACKET_HEADER_FORMAT,
+        buffer,
+        GAME_PACKET_SIZE,
+        &header->magic,
+        &header->version,
+        &header->packet_type,
+        &header->sequence_num,
+        &header->timestamp,
+        &header->payload_length,
+        &header->flags,
+        header->session_id,
+        &header->position[0],
+        &header->position[1],
+        &header->position[2],
+        &header->rotation[0],
+        &header->rotation[1],
+        &header->rotation[2],
+        &header->health,
+        &header->checksum);
+}
+
+/// Return the histogram bucket of a value.
+/// @param[in] value The value.
+/// @return The index of the bucket.
+static size_t __bench_histogram_index(uint64_t value)
+{
+    if (value < (1 << BENCH_HISTOGRAM_SUB_BITS))
+    {
+        return (size_t)value;
+    }
+
+    size_t exponent = 63 - (size_t)__builtin_clzll(value);
+    size_t mantissa = (value >> (exponent - BENCH_HISTOGRAM_SUB_BITS))
+                    & ((1 << BENCH_HISTOGRAM_SUB_BITS) - 1);
+
+    return ((exponent - BENCH_HISTOGRAM_SUB_BITS + 1) << BENCH_HISTOGRAM_SUB_BITS) + mantissa;
+}
+
+/// Return the smallest value in a histogram bucket.
+/// @param[in] index The index of the bucket.
+/// @return The value.
+static uint64_t __bench_histogram_value(size_t index)
+{
+    if (index < (1 << BENCH_HISTOGRAM_SUB_BITS))
+    {
+        return index;
+    }
+
+    size_t exponent = (index >> BENCH_HISTOGRAM_SUB_BITS) + BENCH_HISTOGRAM_SUB_BITS - 1;
+    size_t mantissa = index & ((1 << BENCH_HISTOGRAM_SUB_BITS) - 1);
+
+    return (uint64_t)((1 << BENCH_HISTOGRAM_SUB_BITS) + mantissa)
+        << (exponent - BENCH_HISTOGRAM_SUB_BITS);
+}
+
+/// Add a value to a histogram.
+/// @param[inout] histogram The histogram.
+/// @param[in] value The value.
+static void __bench_histogram_add(histogram_t *histogram, uint64_t value)
+{
+    histogram->counts[__bench_histogram_index(value)]++;
+    histogram->total++;
+}
+
+/// Add every value of one histogram to another.
+/// @param[inout] histogram The histogram to add to.
+/// @param[in] other The histogram to add.
+static void __bench_histogram_merge(histogram_t *histogram, const histogram_t *other)
+{
+    for (size_t i = 0; i < BENCH_HISTOGRAM_SIZE; i++)
+    {
+        histogram->counts[i] += other->counts[i];
+    }
+
+    histogram->total += other->total;
+}
+
+/// Return a percentile of the values in a histogram.
+/// @param[in] histogram The histogram.
+/// @param[in] percentile The percentile, between 0 and 1.
+/// @return The smallest value of the bucket holding the percentile, or 0 if the histogram is empty.
+static uint64_t __bench_histogram_percentile(const histogram_t *histogram, double percentile)
+{
+    uint64_t rank  = (uint64_t)(percentile * (double)histogram->total);
+    uint64_t count = 0;
+
+    for (size_t i = 0; i < BENCH_HISTOGRAM_SIZE; i++)
+    {
+        count += histogram->counts[i];
+
+        if (count > rank)
+        {
+            return __bench_histogram_value(i);
+        }
+    }
+
+    return 0;
+}
+
+/// Answer every request in a buffer of packed messages.
+/// @param[inout] stats The statistics of the server.
+/// @param[in] in The packed requests.
+/// @param[in] size The size of the requests, which must be a multiple of GAME_PACKET_SIZE.
+/// @param[out] out The packed replies, which must hold as many bytes as the requests.
+/// @return The size of the replies.
+static size_t __bench_serve_messages(stats_t *stats, const uint8_t *in, size_t size, uint8_t *out)
+{
+    game_packet_header_t header;
+    size_t               out_size = 0;
+    uint64_t             start    = __bench_cpu_now();
+
+    for (size_t offset = 0; offset < size; offset += GAME_PACKET_SIZE)
+    {
+        if (__bench_unpack(in + offset, &header) != GAME_PACKET_SIZE
+            || header.magic != GAME_PACKET_MAGIC || header.packet_type != GAME_PACKET_REQUEST)
+        {
+            continue;
+        }
+
+        header.packet_type = GAME_PACKET_REPLY;
+        header.health--;
+
+        out_size += __bench_pack(&header, out + out_size);
+    }
+
+    stats->cstruct_ns += __bench_cpu_now() - start;
+
+    return out_size;
+}
+
+/// Answer datagrams until every client has finished.
+/// @param[inout] server The server.
+/// @return NULL.
+static void *__bench_udp_server(server_t *server)
+{
+    static uint8_t in[BENCH_BATCH_SIZE][GAME_PACKET_SIZE];
+    static uint8_t out[BENCH_BATCH_SIZE][GAME_PACKET_SIZE];
+
+    struct sockaddr_in sources[BENCH_BATCH_SIZE];
+    struct iovec       in_iov[BENCH_BATCH_SIZE];
+    struct iovec       out_iov[BENCH_BATCH_SIZE];
+    struct mmsghdr     in_messages[BENCH_BATCH_SIZE];
+    struct mmsghdr     out_messages[BENCH_BATCH_SIZE];
+
+    int buffer_size = 4 << 20;
+    setsockopt(server->fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+
+    int                epoll_fd = epoll_create1(0);
+    struct epoll_event event    = {.events = EPOLLIN, .data.fd = server->fd};
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server->fd, &event);
+
+    while (atomic_load(&__bench_serving))
+    {
+        if (epoll_wait(epoll_fd, &event, 1, 10) <= 0)
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < BENCH_BATCH_SIZE; i++)
+        {
+            in_iov[i] = (struct iovec) {.iov_base = in[i], .iov_len = GAME_PACKET_SIZE};
+            in_messages[i].msg_hdr = (struct msghdr) {
+                .msg_name    = &sources[i],
+                .msg_namelen = sizeof(sources[i]),
+                .msg_iov     = &in_iov[i],
+                .msg_iovlen  = 1,
+            };
+        }
+
+        int count = recvmmsg(server->fd, in_messages, BENCH_BATCH_SIZE, MSG_DONTWAIT, NULL);
+        int sent  = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            if (in_messages[i].msg_len != GAME_PACKET_SIZE
+                || __bench_serve_messages(&server->stats, in[i], GAME_PACKET_SIZE, out[sent]) == 0)
+            {
+                continue;
+            }
+
+            out_iov[sent] = (struct iovec) {.iov_base = out[sent], .iov_len = GAME_PACKET_SIZE};
+            out_messages[sent].msg_hdr = (struct msghdr) {
+                .msg_name    = &sources[i],
+                .msg_namelen = in_messages[i].msg_hdr.msg_namelen,
+                .msg_iov     = &out_iov[sent],
+                .msg_iovlen  = 1,
+            };
+            sent++;
+        }
+
+        // NOTE(Caleb): Replies which don't fit in the socket buffer are dropped, like any datagram
+        for (int i = 0; i < sent;)
+        {
+            int result = sendmmsg(server->fd, out_messages + i, sent - i, 0);
+            if (result <= 0)
+            {
+                break;
+            }
+
+            i += result;
+        }
+    }
+
+    close(epoll_fd);
+
+    return NULL;
+}
+
+/// Flush as much of the pending output of a connection as the socket accepts.
+/// @param[inout] connection The connection.
+/// @return 0 on success, or -1 if the connection failed.
+static int __bench_flush(connection_t *connection)
+{
+    while (connection->out_size > 0)
+    {
+        ssize_t result = write(connection->fd, connection->out, connection->out_size);
+        if (result < 0)
+        {
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+
+        memmove(connection->out, connection->out + result, connection->out_size - result);
+        connection->out_size -= result;
+    }
+
+    return 0;
+}
+
+/// Answer the requests of every connection until every client has finished.
+/// @param[inout] server The server.
+/// @return NULL.
+static void *__bench_tcp_server(server_t *server)
+{
+    int                epoll_fd = epoll_create1(0);
+    struct epoll_event events[16];
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server->fd, &event);
+
+    while (atomic_load(&__bench_serving))
+    {
+        int count = epoll_wait(epoll_fd, events, 16, 10);
+
+        for (int i = 0; i < count; i++)
+        {
+            connection_t *connection = events[i].data.ptr;
+
+            // NOTE(Caleb): The listening socket is the only one registered without a connection
+            if (!connection)
+            {
+                int fd = accept4(server->fd, NULL, NULL, SOCK_NONBLOCK);
+                int on = 1;
+
+                if (fd < 0 || !(connection = calloc(1, sizeof(connection_t))))
+                {
+                    continue;
+                }
+
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                connection->fd = fd;
+
+                event = (struct epoll_event) {.events = EPOLLIN, .data.ptr = connection};
+                epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+                continue;
+            }
+
+            ssize_t result = -1;
+            errno          = EAGAIN;
+
+            if ((events[i].events & EPOLLIN) && connection->in_size < sizeof(connection->in))
+            {
+                result = read(
+                    connection->fd,
+                    connection->in + connection->in_size,
+                    sizeof(connection->in) - connection->in_size);
+            }
+
+            if (result > 0)
+            {
+                connection->in_size += result;
+            }
+
+            // NOTE(Caleb): Answer only as many whole requests as there is room to reply to
+            size_t room = sizeof(connection->out) - connection->out_size;
+            size_t size = connection->in_size - connection->in_size % GAME_PACKET_SIZE;
+            size        = size < room ? size : room - room % GAME_PACKET_SIZE;
+
+            connection->out_size += __bench_serve_messages(
+                &server->stats, connection->in, size, connection->out + connection->out_size);
+            memmove(connection->in, connection->in + size, connection->in_size - size);
+            connection->in_size -= size;
+
+            if (result == 0 || (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                || __bench_flush(connection) < 0)
+            {
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+                close(connection->fd);
+                free(connection);
+                continue;
+            }
+
+            event.events   = connection->out_size > 0 ? EPOLLIN | EPOLLOUT : EPOLLIN;
+            event.data.ptr = connection;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+        }
+    }
+
+    close(epoll_fd);
+
+    return NULL;
+}
+
+/// Run the server.
+/// @param[inout] arg The server.
+/// @return NULL.
+static void *__bench_server(void *arg)
+{
+    server_t *server = arg;
+
+    return server->tcp ? __bench_tcp_server(server) : __bench_udp_server(server);
+}
+
+/// Send batches of requests to the server, and time the replies, until the benchmark ends.
+/// @param[inout] arg The client.
+/// @return NULL.
+static void *__bench_client(void *arg)
+{
+    client_t *client = arg;
+
+    uint8_t        out[BENCH_BATCH_SIZE * GAME_PACKET_SIZE];
+    uint8_t        in[BENCH_BATCH_SIZE * GAME_PACKET_SIZE];
+    struct iovec   iov[BENCH_BATCH_SIZE];
+    struct mmsghdr messages[BENCH_BATCH_SIZE];
+
+    game_packet_header_t header = template_packet_header;
+    uint32_t             first  = client->id << 24;
+
+    int fd = socket(AF_INET, client->tcp ? SOCK_STREAM : SOCK_DGRAM, 0);
+    int on = 1;
+
+    if (fd < 0 || connect(fd, (struct sockaddr *)&client->server, sizeof(client->server)) < 0)
+    {
+        perror("client");
+        return NULL;
+    }
+
+    if (client->tcp)
+    {
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+
+    int                epoll_fd = epoll_create1(0);
+    struct epoll_event event    = {.events = EPOLLIN, .data.fd = fd};
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+
+    while (atomic_load(&__bench_running))
+    {
+        uint64_t start = __bench_cpu_now();
+
+        // NOTE(Caleb): Sequence numbers tell which batch a reply belongs to, and each client has
+        //              its own range of them
+        for (size_t i = 0; i < BENCH_BATCH_SIZE; i++)
+        {
+            header.sequence_num = first + (uint32_t)i;
+            __bench_pack(&header, out + i * GAME_PACKET_SIZE);
+        }
+
+        uint64_t sent = __bench_now();
+        client->stats.cstruct_ns += __bench_cpu_now() - start;
+
+        if (client->tcp)
+        {
+            for (size_t size = 0; size < sizeof(out);)
+            {
+                ssize_t result = write(fd, out + size, sizeof(out) - size);
+                if (result < 0)
+                {
+                    perror("client");
+                    goto done;
+                }
+
+                size += result;
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < BENCH_BATCH_SIZE; i++)
+            {
+                iov[i] = (struct iovec) {
+                    .iov_base = out + i * GAME_PACKET_SIZE,
+                    .iov_len  = GAME_PACKET_SIZE,
+                };
+                messages[i].msg_hdr = (struct msghdr) {.msg_iov = &iov[i], .msg_iovlen = 1};
+            }
+
+            for (int i = 0; i < BENCH_BATCH_SIZE;)
+            {
+                int result = sendmmsg(fd, messages + i, BENCH_BATCH_SIZE - i, 0);
+                if (result < 0)
+                {
+                    perror("client");
+                    goto done;
+                }
+
+                i += result;
+            }
+        }
+
+        size_t received = 0;
+        size_t in_size  = 0;
+
+        while (received < BENCH_BATCH_SIZE)
+        {
+            if (epoll_wait(epoll_fd, &event, 1, BENCH_TIMEOUT_MS) <= 0)
+            {
+                client->stats.lost += BENCH_BATCH_SIZE - received;
+                break;
+            }
+
+            size_t size = 0;
+
+            if (client->tcp)
+            {
+                ssize_t result = recv(fd, in + in_size, sizeof(in) - in_size, MSG_DONTWAIT);
+                if (result <= 0)
+                {
+                    continue;
+                }
+
+                in_size += result;
+                size = in_size - in_size % GAME_PACKET_SIZE;
+            }
+            else
+            {
+                for (size_t i = 0; i < BENCH_BATCH_SIZE; i++)
+                {
+                    iov[i] = (struct iovec) {
+                        .iov_base = in + i * GAME_PACKET_SIZE,
+                        .iov_len  = GAME_PACKET_SIZE,
+                    };
+                    messages[i].msg_hdr = (struct msghdr) {.msg_iov = &iov[i], .msg_iovlen = 1};
+                }
+
+                int count = recvmmsg(fd, messages, BENCH_BATCH_SIZE, MSG_DONTWAIT, NULL);
+                if (count <= 0)
+                {
+                    continue;
+                }
+
+                // NOTE(Caleb): Pack short datagrams away, rather than read garbage from them
+                for (int i = 0; i < count; i++)
+                {
+                    if (messages[i].msg_len == GAME_PACKET_SIZE)
+                    {
+                        memmove(in + size, in + i * GAME_PACKET_SIZE, GAME_PACKET_SIZE);
+                        size += GAME_PACKET_SIZE;
+                    }
+                }
+            }
+
+            uint64_t now      = __bench_now();
+            uint64_t unpacked = __bench_cpu_now();
+
+            for (size_t offset = 0; offset < size; offset += GAME_PACKET_SIZE)
+            {
+                game_packet_header_t reply;
+
+                // NOTE(Caleb): Late replies to a batch which already timed out are ignored
+                if (__bench_unpack(in + offset, &reply) == GAME_PACKET_SIZE
+                    && reply.packet_type == GAME_PACKET_REPLY && reply.sequence_num >= first
+                    && reply.sequence_num - first < BENCH_BATCH_SIZE)
+                {
+                    __bench_histogram_add(&client->stats.latency, now - sent);
+                    received++;
+                }
+            }
+
+            client->stats.cstruct_ns += __bench_cpu_now() - unpacked;
+
+            if (client->tcp)
+            {
+                memmove(in, in + size, in_size - size);
+                in_size -= size;
+            }
+        }
+
+        client->stats.received += received;
+        first = (client->id << 24) | ((first + BENCH_BATCH_SIZE) & 0xFFFFFF);
+    }
+
+done:
+    close(epoll_fd);
+    close(fd);
+
+    return NULL;
+}
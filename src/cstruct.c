@@ -1,10 +1,64 @@
 #include "cstruct.h"
 
+#include <limits.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// NOTE(Caleb): Number of bytes of records that cstruct_swap_inplace converts per pass over the
+// format string; small enough that every field of every record in the block stays in L1 cache
+#define __CSTRUCT_SWAP_BLOCK_SIZE (16 * 1024)
+
+// NOTE(Caleb): Number of bytes that a long run is copied and converted in at a time; small enough
+// to stay in L1 cache between being written and being byte swapped
+#define __CSTRUCT_CHUNK_SIZE (4 * 1024)
+
+// NOTE(Caleb): Runs of at least this many bytes are written with non-temporal stores, which bypass
+// the cache, since an output this much larger than a typical last level cache would only evict
+// everything else from it. Define CSTRUCT_STREAM_THRESHOLD to tune it for a particular machine.
+#if !defined(CSTRUCT_STREAM_THRESHOLD)
+#define CSTRUCT_STREAM_THRESHOLD (32 * 1024 * 1024)
+#endif
+
+// NOTE(Caleb): Maximum nesting depth of parenthesised groups within a format string
+#define __CSTRUCT_MAX_GROUP_DEPTH 8
+
+/// The byte order, sizes, and alignment selected by the prefix of a format string.
+typedef struct
+{
+    size_t start;         // Index of the first format character after the prefix
+    bool   little_endian; // True if multi-byte values are packed in little-endian order
+    bool   native;        // True for `@`: native sizes for `l` and `L`, and native alignment
+    bool   key;           // True for `^`: big-endian values, transformed to sort with memcmp
+} __cstruct_mode_t;
+
+/// State for walking a format string one format character at a time. Groups are run as loops over
+/// the same span of the format string, and are never expanded.
+typedef struct
+{
+    const char *format;
+    size_t      i;
+    size_t      depth;
+
+    // NOTE(Caleb): Only tracked for native alignment, where padding is inserted before each value
+    bool    native;
+    size_t  offset;             // Offset of the next format character within the packed blob
+    char    pending_char;       // Format character to produce after inserted padding, or '\0'
+    int64_t pending_multiplier; // Repeat count of the pending format character
+
+    struct
+    {
+        size_t  start;     // Index of the first format character inside the group
+        int64_t remaining; // Number of iterations left, including the current one
+        size_t  alignment; // Alignment of each iteration of the group, under native alignment
+    } groups[__CSTRUCT_MAX_GROUP_DEPTH];
+} __cstruct_cursor_t;
+
 /// Return true if the character is a digit, and false otherwise.
 /// @param[in] c Character to check.
 /// @return True if the character is a digit, and false otherwise.
@@ -15,28 +69,206 @@ static inline bool __cstruct_isdigit(char c);
 /// @param format The format string.
 /// @param[inout] i On entry, the supposed start index of the multiplier.
 ///                 On exit, the index of the supposed next format character.
-/// @return The multiplier, or -1 if the format string is invalid.
-static int32_t __cstruct_parse_multiplier(const char *format, size_t *i);
+/// @return The multiplier, or -1 if the format string is invalid or the multiplier does not fit in
+///         an int64_t.
+static int64_t __cstruct_parse_multiplier(const char *format, size_t *i);
+
+/// Parse the prefix of a format string.
+/// @param[in] format The format string.
+/// @param[out] mode The byte order, sizes, and alignment selected by the prefix.
+static void __cstruct_parse_mode(const char *format, __cstruct_mode_t *mode);
+
+/// Return the format character which stands in for the given one, given the sizes selected by the
+/// prefix of the format string. Under native sizes, `l` and `L` become the standard format
+/// characters of the same size as a C long.
+/// @param[in] c The format character.
+/// @param[in] native True if native sizes are selected.
+/// @return The format character to use in place of the given one.
+static inline char __cstruct_native_char(char c, bool native);
+
+/// Return the native alignment of the type which the given format character represents.
+/// @param[in] c The format character, which must not be `l` or `L`.
+/// @return The alignment in bytes, or 1 if the character is not a valid type.
+static size_t __cstruct_calculate_alignment(char c);
+
+/// Round an offset up to a multiple of an alignment.
+/// @param[in] offset The offset.
+/// @param[in] alignment The alignment, which must be a power of two.
+/// @return The rounded offset.
+static inline size_t __cstruct_align(size_t offset, size_t alignment);
+
+/// Initialize a cursor to walk the given format string.
+/// @param[out] cursor The cursor to initialize.
+/// @param[in] format The format string.
+/// @param[in] mode The mode selected by the prefix of the format string.
+static void __cstruct_cursor_init(
+    __cstruct_cursor_t *cursor, const char *format, const __cstruct_mode_t *mode);
+
+/// Advance the cursor to the next format character, entering, repeating, and leaving groups as
+/// needed. Under native alignment, padding is produced as `x` runs wherever a value or group must
+/// be aligned.
+/// @param[inout] cursor The cursor.
+/// @param[out] format_char The next format character.
+/// @param[out] multiplier The repeat count of the next format character.
+/// @return 1 if a format character was produced, 0 if the end of the format string was reached, or
+///         -1 if the format string is invalid.
+static int __cstruct_cursor_next(
+    __cstruct_cursor_t *cursor, char *format_char, int64_t *multiplier);
+
+/// Return the size of the format characters from the given index up to the end of the enclosing
+/// group, or the end of the format string.
+/// @param[in] format The format string.
+/// @param[inout] i On entry, the index of the first format character of the group.
+///                 On exit, the index of the closing parenthesis, or the end of the format string.
+/// @param[in] depth The nesting depth of the group.
+/// @param[in] native True if native sizes and alignment are selected.
+/// @param[out] alignment The largest alignment of any value in the group, which is 1 unless native
+///                       alignment is selected.
+/// @return The size of a single iteration of the group, without trailing padding, or -1 if the
+///         format string is invalid.
+static ssize_t __cstruct_sizeof_group(
+    const char *format, size_t *i, size_t depth, bool native, size_t *alignment);
+
+/// Return the number of fields in the format string, as used by deltas: one for each numeric value,
+/// and one for each `s` string.
+/// @param[in] format The format string.
+/// @param[in] mode The mode selected by the prefix of the format string.
+/// @return The number of fields, or -1 if the format string is invalid.
+static ssize_t __cstruct_count_fields(const char *format, const __cstruct_mode_t *mode);
+
+/// Add up the sizes of the fields present in a delta, and copy them into a record.
+/// @param[in] format The format string, which must already have been validated.
+/// @param[in] mode The mode selected by the prefix of the format string.
+/// @param[in] mask The mask of the delta, with one bit per field.
+/// @param[out] record The record to copy the fields into, or NULL to only add up their sizes.
+/// @param[in] values The packed fields which follow the mask, which must hold all of them if record
+///                   is not NULL.
+/// @return The total size of the fields present in the delta.
+static size_t __cstruct_copy_delta_fields(
+    const char             *format,
+    const __cstruct_mode_t *mode,
+    const uint8_t          *mask,
+    uint8_t                *record,
+    const uint8_t          *values);
 
 /// Return the size of the type which the given character represents.
 /// @param[in] c Character to check.
 /// @param[in] multiplier Multiplier to apply to the size.
 /// @return The size of the type which the given character represents multiplied by the given
-///         multiplier, or -1 if the character is not a valid type.
-static ssize_t __cstruct_calculate_size(char c, int multiplier);
+///         multiplier, or -1 if the character is not a valid type or the size does not fit in a
+///         ssize_t.
+static ssize_t __cstruct_calculate_size(char c, int64_t multiplier);
+
+/// Return true if the host stores multi-byte values in little-endian order, and false otherwise.
+/// @return True if the host is little-endian, and false otherwise.
+static inline bool __cstruct_host_is_little_endian(void);
+
+/// Reverse the byte order of each element in a run of contiguous, equally sized elements.
+/// @param[inout] data The start of the run.
+/// @param[in] width The size of each element in bytes (2, 4, or 8).
+/// @param[in] n The number of elements in the run.
+static void __cstruct_swap_run(uint8_t *data, size_t width, size_t n);
+
+/// Reverse the byte order of every multi-byte field in a block of consecutive records.
+/// @param[in] format The format string, which must already have been validated.
+/// @param[in] mode The mode selected by the prefix of the format string.
+/// @param[inout] records The start of the first record in the block.
+/// @param[in] record_size The size of a single record.
+/// @param[in] count The number of records in the block.
+static void __cstruct_swap_records(
+    const char             *format,
+    const __cstruct_mode_t *mode,
+    uint8_t                *records,
+    size_t                  record_size,
+    size_t                  count);
+
+/// Copy a run of bytes, or zero it, with non-temporal stores if the run is long enough.
+/// @param[out] dest The destination.
+/// @param[in] src The source, or NULL to zero the destination.
+/// @param[in] size The number of bytes.
+static inline void __cstruct_store_run(uint8_t *dest, const uint8_t *src, size_t size);
+
+/// Copy a run of bytes, or zero it, with non-temporal stores.
+/// @param[out] dest The destination.
+/// @param[in] src The source, or NULL to zero the destination.
+/// @param[in] size The number of bytes.
+static void __cstruct_stream_run(uint8_t *dest, const uint8_t *src, size_t size);
+
+/// Copy a run of contiguous, equally sized elements, and reverse the byte order of each. The run is
+/// converted in chunks which stay in L1 cache, and written with non-temporal stores if it is long
+/// enough.
+/// @param[out] dest The destination.
+/// @param[in] src The source.
+/// @param[in] width The size of each element in bytes (2, 4, or 8).
+/// @param[in] size The number of bytes, which must be a multiple of width.
+static void __cstruct_swap_copy_run(uint8_t *dest, const uint8_t *src, size_t width, size_t size);
 
 // Packing/Unpacking Functions ---------------------------------------------------------------------
 
 typedef uint16_t (*__cstruct_pack16_f)(uint16_t x);
-typedef uint16_t (*__cstruct_unpack16_f)(uint16_t x);
 typedef uint32_t (*__cstruct_pack32_f)(uint32_t x);
-typedef uint32_t (*__cstruct_unpack32_f)(uint32_t x);
 typedef uint64_t (*__cstruct_pack64_f)(uint64_t x);
-typedef uint64_t (*__cstruct_unpack64_f)(uint64_t x);
 typedef uint32_t (*__cstruct_pack_float_f)(float x);
-typedef float (*__cstruct_unpack_float_f)(uint32_t x);
 typedef uint64_t (*__cstruct_pack_double_f)(double x);
-typedef double (*__cstruct_unpack_double_f)(uint64_t x);
+
+/// The packing functions for a single byte order.
+typedef struct
+{
+    __cstruct_pack16_f      pack16;
+    __cstruct_pack32_f      pack32;
+    __cstruct_pack64_f      pack64;
+    __cstruct_pack_float_f  pack_float;
+    __cstruct_pack_double_f pack_double;
+} __cstruct_packers_t;
+
+/// Select the packing functions for the byte order of a format string.
+/// @param[in] mode The mode selected by the prefix of the format string.
+/// @param[out] packers The packing functions for the byte order of the format string.
+static void __cstruct_select_packers(const __cstruct_mode_t *mode, __cstruct_packers_t *packers);
+
+/// Pack a single value, taken from the argument list, for a numeric format character.
+/// @param[in] format_char The format character of the value.
+/// @param[out] dest The location to pack the value into.
+/// @param[inout] args The argument list to take the value from.
+/// @param[in] packers The packing functions for the byte order of the format string.
+/// @return The size of the packed value, or -1 if the format character is not numeric.
+static inline ssize_t __cstruct_pack_value(
+    char format_char, uint8_t *dest, va_list *args, const __cstruct_packers_t *packers);
+
+/// Convert a single numeric value between the host byte order and the packed byte order.
+/// @param[in] width The size of the value in bytes (1, 2, 4, or 8).
+/// @param[in] src The value to convert.
+/// @param[out] dest The location to store the converted value.
+/// @param[in] packers The packing functions for the byte order of the format string.
+static inline void __cstruct_convert_value(
+    size_t width, const uint8_t *src, uint8_t *dest, const __cstruct_packers_t *packers);
+
+/// Apply the order-preserving key transform to a single value packed in big-endian order, or
+/// reverse it. Signed integers have their sign bit flipped, while floating point values have their
+/// sign bit flipped if positive, or every bit flipped if negative. Other values are left untouched.
+/// @param[in] format_char The format character of the value.
+/// @param[inout] value The packed value.
+/// @param[in] encode True to apply the transform after packing, or false to reverse it before
+///                   unpacking.
+static inline void __cstruct_transform_key(char format_char, uint8_t *value, bool encode);
+
+/// Transfer values between the members of a struct and a packed blob.
+/// @param[in] format The format string describing the data layout.
+/// @param[inout] packed The packed blob, which is only written to when packing.
+/// @param[in] packed_size The length of the packed blob.
+/// @param[inout] object The struct, which is only written to when unpacking.
+/// @param[in] offsets The offset of each value within the struct.
+/// @param[in] offset_count The number of offsets.
+/// @param[in] pack True to pack the struct into the blob, or false to unpack the blob into it.
+/// @return The size of the packed blob, or -1 if an error occurred.
+static ssize_t __cstruct_transfer_struct(
+    const char   *format,
+    uint8_t      *packed,
+    size_t        packed_size,
+    uint8_t      *object,
+    const size_t *offsets,
+    size_t        offset_count,
+    bool          pack);
 
 static inline uint16_t __cstruct_pack_be16(uint16_t x);
 static inline uint16_t __cstruct_pack_le16(uint16_t x);
@@ -63,450 +295,1674 @@ static inline uint64_t __cstruct_pack_double_le(double x);
 static inline double   __cstruct_unpack_double_be(uint64_t x);
 static inline double   __cstruct_unpack_double_le(uint64_t x);
 
+// NOTE(Caleb): Key variants, for `^`, which pack in big-endian order after the key transform
+static inline uint8_t  __cstruct_pack_8(uint8_t x);
+static inline uint8_t  __cstruct_pack_key8(uint8_t x);
+static inline uint8_t  __cstruct_unpack_8(uint8_t x);
+static inline uint8_t  __cstruct_unpack_key8(uint8_t x);
+static inline uint16_t __cstruct_pack_key16(uint16_t x);
+static inline uint16_t __cstruct_unpack_key16(uint16_t x);
+static inline uint32_t __cstruct_pack_key32(uint32_t x);
+static inline uint32_t __cstruct_unpack_key32(uint32_t x);
+static inline uint64_t __cstruct_pack_key64(uint64_t x);
+static inline uint64_t __cstruct_unpack_key64(uint64_t x);
+static inline uint32_t __cstruct_pack_float_key(float x);
+static inline float    __cstruct_unpack_float_key(uint32_t x);
+static inline uint64_t __cstruct_pack_double_key(double x);
+static inline double   __cstruct_unpack_double_key(uint64_t x);
+
+// Threaded Interpreter ----------------------------------------------------------------------------
+
+// NOTE(Caleb): cstruct_vpack and cstruct_vunpack first decode a batch of the format string into a
+// stream of operations, each of which packs or unpacks a whole run of values with a handler
+// specialized for its type and byte order, and then run the stream. Handlers are chained with
+// computed gotos where the compiler supports them, and with a switch otherwise.
+#if defined(__GNUC__) && !defined(CSTRUCT_NO_COMPUTED_GOTO)
+#define __CSTRUCT_HAVE_COMPUTED_GOTO
+#endif
+
+// NOTE(Caleb): Maximum number of operations decoded at once; a longer format string, or a group
+// with many iterations, is decoded and run one batch at a time
+#define __CSTRUCT_OP_BATCH_SIZE 32
+
+#define __CSTRUCT_OPS(X)                                                                           \
+    X(END)                                                                                         \
+    X(PAD)                                                                                         \
+    X(STRING)                                                                                      \
+    X(8)                                                                                           \
+    X(KEY8)                                                                                        \
+    X(BE16)                                                                                        \
+    X(LE16)                                                                                        \
+    X(KEY16)                                                                                       \
+    X(BE32)                                                                                        \
+    X(LE32)                                                                                        \
+    X(KEY32)                                                                                       \
+    X(BE64)                                                                                        \
+    X(LE64)                                                                                        \
+    X(KEY64)                                                                                       \
+    X(BE_FLOAT)                                                                                    \
+    X(LE_FLOAT)                                                                                    \
+    X(KEY_FLOAT)                                                                                   \
+    X(BE_DOUBLE)                                                                                   \
+    X(LE_DOUBLE)                                                                                   \
+    X(KEY_DOUBLE)
+
+#define __CSTRUCT_OP_ENUM(name) __CSTRUCT_OP_##name,
+
+typedef enum
+{
+    __CSTRUCT_OPS(__CSTRUCT_OP_ENUM) __CSTRUCT_OP_COUNT
+} __cstruct_opcode_t;
+
+/// A single operation of a decoded format string.
+typedef struct
+{
+    size_t  count;  // The number of values, or the number of bytes for padding and strings
+    uint8_t opcode; // The handler which runs the operation
+} __cstruct_op_t;
+
+/// The operation which packs and unpacks a format character, and the size of a single value.
+typedef struct
+{
+    uint8_t width;  // The size of a single value, or 0 if the format character is invalid
+    uint8_t opcode; // The operation for runs of the format character
+} __cstruct_op_info_t;
+
+// NOTE(Caleb): Indexed by byte order (big-endian, little-endian, key), then by format character.
+// Under `^`, only signed values are transformed, so unsigned ones are packed as big-endian.
+static const __cstruct_op_info_t __cstruct_op_table[3][128] = {
+    {
+        ['x'] = {1, __CSTRUCT_OP_PAD},       ['s'] = {1, __CSTRUCT_OP_STRING},
+        ['b'] = {1, __CSTRUCT_OP_8},         ['B'] = {1, __CSTRUCT_OP_8},
+        ['h'] = {2, __CSTRUCT_OP_BE16},      ['H'] = {2, __CSTRUCT_OP_BE16},
+        ['i'] = {4, __CSTRUCT_OP_BE32},      ['I'] = {4, __CSTRUCT_OP_BE32},
+        ['l'] = {4, __CSTRUCT_OP_BE32},      ['L'] = {4, __CSTRUCT_OP_BE32},
+        ['q'] = {8, __CSTRUCT_OP_BE64},      ['Q'] = {8, __CSTRUCT_OP_BE64},
+        ['f'] = {4, __CSTRUCT_OP_BE_FLOAT},  ['d'] = {8, __CSTRUCT_OP_BE_DOUBLE},
+    },
+    {
+        ['x'] = {1, __CSTRUCT_OP_PAD},       ['s'] = {1, __CSTRUCT_OP_STRING},
+        ['b'] = {1, __CSTRUCT_OP_8},         ['B'] = {1, __CSTRUCT_OP_8},
+        ['h'] = {2, __CSTRUCT_OP_LE16},      ['H'] = {2, __CSTRUCT_OP_LE16},
+        ['i'] = {4, __CSTRUCT_OP_LE32},      ['I'] = {4, __CSTRUCT_OP_LE32},
+        ['l'] = {4, __CSTRUCT_OP_LE32},      ['L'] = {4, __CSTRUCT_OP_LE32},
+        ['q'] = {8, __CSTRUCT_OP_LE64},      ['Q'] = {8, __CSTRUCT_OP_LE64},
+        ['f'] = {4, __CSTRUCT_OP_LE_FLOAT},  ['d'] = {8, __CSTRUCT_OP_LE_DOUBLE},
+    },
+    {
+        ['x'] = {1, __CSTRUCT_OP_PAD},       ['s'] = {1, __CSTRUCT_OP_STRING},
+        ['b'] = {1, __CSTRUCT_OP_KEY8},      ['B'] = {1, __CSTRUCT_OP_8},
+        ['h'] = {2, __CSTRUCT_OP_KEY16},     ['H'] = {2, __CSTRUCT_OP_BE16},
+        ['i'] = {4, __CSTRUCT_OP_KEY32},     ['I'] = {4, __CSTRUCT_OP_BE32},
+        ['l'] = {4, __CSTRUCT_OP_KEY32},     ['L'] = {4, __CSTRUCT_OP_BE32},
+        ['q'] = {8, __CSTRUCT_OP_KEY64},     ['Q'] = {8, __CSTRUCT_OP_BE64},
+        ['f'] = {4, __CSTRUCT_OP_KEY_FLOAT}, ['d'] = {8, __CSTRUCT_OP_KEY_DOUBLE},
+    },
+};
+
+/// Decode the next batch of a format string into a stream of operations, which is terminated by
+/// __CSTRUCT_OP_END. Consecutive runs with the same operation are merged.
+/// @param[inout] cursor The cursor over the format string.
+/// @param[in] mode The mode selected by the prefix of the format string.
+/// @param[out] ops The stream, which holds up to __CSTRUCT_OP_BATCH_SIZE + 1 operations.
+/// @param[out] size The number of packed bytes which the batch covers.
+/// @return 1 if a batch was decoded, 0 if the format string is exhausted, or -1 if the format
+///         string is invalid.
+static int __cstruct_decode_ops(
+    __cstruct_cursor_t *cursor, const __cstruct_mode_t *mode, __cstruct_op_t *ops, size_t *size);
+
+/// Run a stream of operations, packing values taken from the argument list.
+/// @param[in] op The first operation of the stream.
+/// @param[out] dest The location to pack the values into, which must hold the whole batch.
+/// @param[inout] args The argument list to take the values from.
+static void __cstruct_run_pack(const __cstruct_op_t *op, uint8_t *dest, va_list *args);
+
+/// Run a stream of operations, unpacking values into the pointers taken from the argument list.
+/// @param[in] op The first operation of the stream.
+/// @param[in] src The location to unpack the values from, which must hold the whole batch.
+/// @param[inout] args The argument list to take the pointers from.
+static void __cstruct_run_unpack(const __cstruct_op_t *op, const uint8_t *src, va_list *args);
+
 // Public API --------------------------------------------------------------------------------------
 
 ssize_t cstruct_pack(const char *format, void *buffer, size_t buffer_size, ...)
+{
+    va_list args;
+    va_start(args, buffer_size);
+
+    ssize_t total_size = cstruct_vpack(format, buffer, buffer_size, args);
+
+    va_end(args);
+    return total_size;
+}
+
+ssize_t cstruct_vpack(const char *format, void *buffer, size_t buffer_size, va_list ap)
 {
     if (!format || *format == '\0')
     {
         return -1;
     }
 
-    size_t  i          = 0;
-    ssize_t total_size = 0;
+    size_t  total_size = 0;
+    size_t  batch_size = 0;
+    int     status     = 0;
     va_list args;
 
-    // NOTE(Caleb):
-    // - Select packing functions here to avoid unnecessary branching in the packing loop
-    // - Assume big endian unless otherwise specified
-    __cstruct_pack16_f      pack16      = __cstruct_pack_be16;
-    __cstruct_pack32_f      pack32      = __cstruct_pack_be32;
-    __cstruct_pack64_f      pack64      = __cstruct_pack_be64;
-    __cstruct_pack_float_f  pack_float  = __cstruct_pack_float_be;
-    __cstruct_pack_double_f pack_double = __cstruct_pack_double_be;
+    __cstruct_mode_t mode;
+    __cstruct_parse_mode(format, &mode);
 
-    if (format[0] == '!' || format[0] == '<' || format[0] == '>')
-    {
-        if (format[0] == '<')
-        {
-            pack16      = __cstruct_pack_le16;
-            pack32      = __cstruct_pack_le32;
-            pack64      = __cstruct_pack_le64;
-            pack_float  = __cstruct_pack_float_le;
-            pack_double = __cstruct_pack_double_le;
-        }
+    __cstruct_cursor_t cursor;
+    __cstruct_cursor_init(&cursor, format, &mode);
 
-        i++;
-    }
+    __cstruct_op_t ops[__CSTRUCT_OP_BATCH_SIZE + 1];
 
-    va_start(args, buffer_size);
+    // NOTE(Caleb): Work on a copy, so that the values can be taken through a pointer
+    va_copy(args, ap);
 
-    while (format[i] != '\0')
+    while ((status = __cstruct_decode_ops(&cursor, &mode, ops, &batch_size)) > 0)
     {
-        int32_t multiplier = __cstruct_parse_multiplier(format, &i);
-        if (multiplier <= 0)
+        // NOTE(Caleb): If true, the buffer is too small to fit the batch
+        if (batch_size > buffer_size - total_size)
         {
             va_end(args);
             return -1;
         }
 
-        char format_char = format[i];
+        __cstruct_run_pack(ops, (uint8_t *)buffer + total_size, &args);
+        total_size += batch_size;
+    }
 
-        size_t size = __cstruct_calculate_size(format_char, multiplier);
-        if (size == 0)
-        {
-            va_end(args);
-            return -1;
-        }
+    va_end(args);
+    return status < 0 ? -1 : (ssize_t)total_size;
+}
 
-        // NOTE(Caleb): If true, the buffer is too small to fit the next value
-        if (total_size + size > buffer_size)
-        {
-            va_end(args);
-            return -1;
-        }
+ssize_t cstruct_unpack(const char *format, const void *buffer, size_t buffer_size, ...)
+{
+    va_list args;
+    va_start(args, buffer_size);
 
-        uint8_t *dest = (uint8_t *)buffer + total_size;
+    ssize_t bytes_read = cstruct_vunpack(format, buffer, buffer_size, args);
 
-        if (format_char == 'x')
-        {
-            memset(dest, 0, size);
-        }
-        else if (format_char == 's')
-        {
-            void *src = va_arg(args, void *);
-            memset(dest, 0, size);
+    va_end(args);
+    return bytes_read;
+}
 
-            if (src)
-            {
-                memcpy(dest, src, size);
-            }
-        }
-        else
-        {
-            for (size_t j = 0; j < size; j += size / multiplier)
-            {
-                switch (format_char)
-                {
-                    case 'b':
-                    case 'B':
-                    {
-                        uint8_t x = (uint8_t)va_arg(args, int);
-                        memcpy(dest + j, &x, 1);
+ssize_t cstruct_vunpack(const char *format, const void *buffer, size_t buffer_size, va_list ap)
+{
+    if (!format || *format == '\0')
+    {
+        return -1;
+    }
 
-                        break;
-                    }
+    size_t  bytes_read = 0;
+    size_t  batch_size = 0;
+    int     status     = 0;
+    va_list args;
 
-                    case 'h':
-                    case 'H':
-                    {
-                        uint16_t x = (uint16_t)va_arg(args, int);
-                        x          = pack16(x);
+    __cstruct_mode_t mode;
+    __cstruct_parse_mode(format, &mode);
 
-                        memcpy(dest + j, &x, 2);
+    __cstruct_cursor_t cursor;
+    __cstruct_cursor_init(&cursor, format, &mode);
 
-                        break;
-                    }
+    __cstruct_op_t ops[__CSTRUCT_OP_BATCH_SIZE + 1];
 
-                    case 'i':
-                    case 'I':
-                    case 'l':
-                    case 'L':
-                    {
-                        uint32_t x = (uint32_t)va_arg(args, int);
-                        x          = pack32(x);
+    va_copy(args, ap);
 
-                        memcpy(dest + j, &x, 4);
+    while ((status = __cstruct_decode_ops(&cursor, &mode, ops, &batch_size)) > 0)
+    {
+        // NOTE(Caleb): Ensure that we don't read past the end of the buffer
+        if (batch_size > buffer_size - bytes_read)
+        {
+            va_end(args);
+            return -1;
+        }
 
-                        break;
-                    }
+        __cstruct_run_unpack(ops, (const uint8_t *)buffer + bytes_read, &args);
+        bytes_read += batch_size;
+    }
 
-                    case 'q':
-                    case 'Q':
-                    {
-                        uint64_t x = (uint64_t)va_arg(args, uint64_t);
-                        x          = pack64(x);
+    va_end(args);
+    return status < 0 ? -1 : (ssize_t)bytes_read;
+}
 
-                        memcpy(dest + j, &x, 8);
+ssize_t cstruct_sizeof(const char *format)
+{
+    if (!format || *format == '\0')
+    {
+        return -1;
+    }
 
-                        break;
-                    }
+    __cstruct_mode_t mode;
+    __cstruct_parse_mode(format, &mode);
 
-                    case 'f':
-                    {
-                        float    f = (float)va_arg(args, double);
-                        uint32_t u = pack_float(f);
+    size_t i         = mode.start;
+    size_t alignment = 1;
 
-                        memcpy(dest + j, &u, 4);
+    // NOTE(Caleb): As in Python, no trailing padding is added to the end of the format string
+    ssize_t total_size = __cstruct_sizeof_group(format, &i, 0, mode.native, &alignment);
 
-                        break;
-                    }
+    // NOTE(Caleb): If true, the format string has a closing parenthesis without an opening one
+    if (format[i] != '\0')
+    {
+        return -1;
+    }
 
-                    case 'd':
-                    {
-                        double   d = (double)va_arg(args, double);
-                        uint64_t u = pack_double(d);
+    return total_size;
+}
 
-                        memcpy(dest + j, &u, 8);
+ssize_t cstruct_swap_inplace(const char *format, void *buffer, size_t buffer_size, size_t count)
+{
+    // NOTE(Caleb): Validate the whole format string up front so that an invalid format string can
+    // never leave the buffer half converted
+    ssize_t record_size = cstruct_sizeof(format);
+    if (record_size <= 0 || !buffer)
+    {
+        return -1;
+    }
 
-                        break;
-                    }
+    // NOTE(Caleb): If true, the buffer is too small to hold all of the records
+    if (count > buffer_size / (size_t)record_size)
+    {
+        return -1;
+    }
 
-                    default:
-                        va_end(args);
-                        return -1;
-                }
-            }
-        }
+    __cstruct_mode_t mode;
+    __cstruct_parse_mode(format, &mode);
 
-        total_size += size;
-        i++;
+    // NOTE(Caleb): Keys can't be decoded in place by the same call that encodes them
+    if (mode.key)
+    {
+        return -1;
     }
 
-    va_end(args);
-    return total_size;
+    if (mode.little_endian == __cstruct_host_is_little_endian())
+    {
+        return record_size * count;
+    }
+
+    size_t records_per_block = __CSTRUCT_SWAP_BLOCK_SIZE / record_size;
+    if (records_per_block == 0)
+    {
+        records_per_block = 1;
+    }
+
+    for (size_t j = 0; j < count; j += records_per_block)
+    {
+        size_t block_count = count - j < records_per_block ? count - j : records_per_block;
+        __cstruct_swap_records(
+            format, &mode, (uint8_t *)buffer + j * record_size, record_size, block_count);
+    }
+
+    return record_size * count;
 }
 
-ssize_t cstruct_unpack(const char *format, const void *buffer, size_t buffer_size, ...)
+ssize_t cstruct_pack_delta(
+    const char *format, const void *previous, void *buffer, size_t buffer_size, ...)
 {
-    if (!format || *format == '\0')
+    if (!format || *format == '\0' || !buffer)
     {
         return -1;
     }
 
-    size_t  i          = 0;
-    ssize_t bytes_read = 0;
-    va_list args;
+    __cstruct_mode_t mode;
+    __cstruct_parse_mode(format, &mode);
 
-    // NOTE(Caleb):
-    // - Select unpacking functions here to avoid unnecessary branching in the unpacking loop
-    // - Assume big endian unless otherwise specified
-    __cstruct_unpack16_f      unpack16      = __cstruct_unpack_be16;
-    __cstruct_unpack32_f      unpack32      = __cstruct_unpack_be32;
-    __cstruct_unpack64_f      unpack64      = __cstruct_unpack_be64;
-    __cstruct_unpack_float_f  unpack_float  = __cstruct_unpack_float_be;
-    __cstruct_unpack_double_f unpack_double = __cstruct_unpack_double_be;
+    __cstruct_packers_t packers;
+    __cstruct_select_packers(&mode, &packers);
 
-    if (format[0] == '!' || format[0] == '<' || format[0] == '>')
+    ssize_t field_count = __cstruct_count_fields(format, &mode);
+    if (field_count < 0)
     {
-        if (format[0] == '<')
-        {
-            unpack16      = __cstruct_unpack_le16;
-            unpack32      = __cstruct_unpack_le32;
-            unpack64      = __cstruct_unpack_le64;
-            unpack_float  = __cstruct_unpack_float_le;
-            unpack_double = __cstruct_unpack_double_le;
-        }
+        return -1;
+    }
 
-        i++;
+    size_t mask_size = ((size_t)field_count + 7) / 8;
+    if (mask_size > buffer_size)
+    {
+        return -1;
     }
 
-    va_start(args, buffer_size);
+    uint8_t       *mask       = buffer;
+    const uint8_t *prev       = previous;
+    size_t         total_size = mask_size;
+    size_t         offset     = 0;
+    size_t         field      = 0;
+    va_list        args;
 
-    while (format[i] != '\0')
-    {
-        int32_t multiplier = __cstruct_parse_multiplier(format, &i);
-        if (multiplier <= 0)
-        {
-            va_end(args);
-            return -1;
-        }
+    memset(mask, 0, mask_size);
 
-        char format_char = format[i];
+    __cstruct_cursor_t cursor;
+    __cstruct_cursor_init(&cursor, format, &mode);
 
-        ssize_t size = __cstruct_calculate_size(format_char, multiplier);
-        if (size <= 0)
-        {
-            va_end(args);
-            return -1;
-        }
+    char    format_char = '\0';
+    int64_t multiplier  = 0;
 
-        // NOTE(Caleb): Ensure that we don't read past the end of the buffer
-        if ((size_t)(bytes_read + size) > buffer_size)
-        {
-            va_end(args);
-            return -1;
-        }
+    va_start(args, buffer_size);
+
+    while (__cstruct_cursor_next(&cursor, &format_char, &multiplier) > 0)
+    {
+        size_t size = __cstruct_calculate_size(format_char, multiplier);
 
         if (format_char == 'x')
         {
-            bytes_read += size;
-            i++;
-
+            offset += size;
             continue;
         }
 
-        uint8_t *src = (uint8_t *)buffer + bytes_read;
-
         if (format_char == 's')
         {
-            void *dest = va_arg(args, void *);
-            memcpy(dest, src, size);
-        }
-        else
-        {
-            for (ssize_t j = 0; j < size; j += size / multiplier)
-            {
-                switch (format_char)
-                {
-                    // ...
-                    case 'b':
-                    case 'B':
-                    {
-                        uint8_t x = *(src + j);
+            const uint8_t *src     = va_arg(args, const uint8_t *);
+            bool           changed = !prev;
 
-                        uint8_t *dest = va_arg(args, uint8_t *);
-                        *dest         = x;
-
-                        break;
-                    }
-
-                    case 'h':
-                    case 'H':
-                    {
-                        uint16_t x = 0;
-                        memcpy(&x, src + j, 2);
-
-                        uint16_t *dest = va_arg(args, uint16_t *);
-                        *dest          = unpack16(x);
-
-                        break;
-                    }
-
-                    case 'i':
-                    case 'I':
-                    case 'l':
-                    case 'L':
-                    {
-                        uint32_t x = 0;
-                        memcpy(&x, src + j, 4);
+            if (!changed && src)
+            {
+                changed = memcmp(src, prev + offset, size) != 0;
+            }
 
-                        uint32_t *dest = va_arg(args, uint32_t *);
-                        *dest          = unpack32(x);
+            // NOTE(Caleb): A NULL string packs as all zeroes
+            for (size_t j = 0; !changed && !src && j < size; j++)
+            {
+                changed = prev[offset + j] != 0;
+            }
 
-                        break;
-                    }
+            if (changed)
+            {
+                if (total_size + size > buffer_size)
+                {
+                    va_end(args);
+                    return -1;
+                }
 
-                    case 'q':
-                    case 'Q':
-                    {
-                        uint64_t x = 0;
-                        memcpy(&x, src + j, 8);
+                memset((uint8_t *)buffer + total_size, 0, size);
+                if (src)
+                {
+                    memcpy((uint8_t *)buffer + total_size, src, size);
+                }
 
-                        uint64_t *dest = va_arg(args, uint64_t *);
-                        *dest          = unpack64(x);
+                mask[field / 8] |= 1 << (field % 8);
+                total_size      += size;
+            }
 
-                        break;
-                    }
+            offset += size;
+            field++;
 
-                    case 'f':
-                    {
-                        uint32_t x = 0;
-                        memcpy(&x, src + j, 4);
+            continue;
+        }
 
-                        float *dest = va_arg(args, float *);
-                        *dest       = unpack_float(x);
+        for (int64_t j = 0; j < multiplier; j++)
+        {
+            uint8_t value[8];
 
-                        break;
-                    }
+            ssize_t width = __cstruct_pack_value(format_char, value, &args, &packers);
+            if (width < 0)
+            {
+                va_end(args);
+                return -1;
+            }
 
-                    case 'd':
-                    {
-                        uint64_t x = 0;
-                        memcpy(&x, src + j, 8);
+            if (mode.key)
+            {
+                __cstruct_transform_key(format_char, value, true);
+            }
 
-                        double *dest = va_arg(args, double *);
-                        *dest        = unpack_double(x);
+            if (!prev || memcmp(value, prev + offset, width) != 0)
+            {
+                if (total_size + width > buffer_size)
+                {
+                    va_end(args);
+                    return -1;
+                }
 
-                        break;
-                    }
+                memcpy((uint8_t *)buffer + total_size, value, width);
 
-                    default:
-                        va_end(args);
-                        return -1;
-                }
+                mask[field / 8] |= 1 << (field % 8);
+                total_size      += width;
             }
-        }
 
-        bytes_read += size;
-        i++;
+            offset += width;
+            field++;
+        }
     }
 
-    return bytes_read;
+    va_end(args);
+    return total_size;
 }
 
-ssize_t cstruct_sizeof(const char *format)
+ssize_t cstruct_apply_delta(
+    const char *format, void *record, size_t record_size, const void *delta, size_t delta_size)
 {
-    if (!format || *format == '\0')
+    // NOTE(Caleb): Validate the whole format string up front so that an invalid format string can
+    // never leave the record half updated
+    ssize_t size = cstruct_sizeof(format);
+    if (size < 0 || (size_t)size > record_size || !record || !delta)
     {
         return -1;
     }
 
-    size_t  i          = 0;
-    ssize_t total_size = 0;
+    // NOTE(Caleb): The byte order is ignored, as fields are copied as packed
+    __cstruct_mode_t mode;
+    __cstruct_parse_mode(format, &mode);
 
-    // NOTE(Caleb): Skip over the byte order specifier
-    if (format[0] == '!' || format[0] == '<' || format[0] == '>')
+    size_t mask_size = ((size_t)__cstruct_count_fields(format, &mode) + 7) / 8;
+    if (mask_size > delta_size)
     {
-        i++;
+        return -1;
     }
 
-    while (format[i] != '\0')
-    {
-        int32_t multiplier = __cstruct_parse_multiplier(format, &i);
-        if (multiplier <= 0)
-        {
-            return -1;
-        }
-
-        // NOTE(Caleb): At this point, format[i] is the next format character
-        ssize_t size = __cstruct_calculate_size(format[i], multiplier);
-        if (size <= 0)
-        {
-            return -1;
-        }
+    // NOTE(Caleb): Add up the fields present in the delta before copying any of them, so that a
+    // truncated delta can never leave the record half updated either
+    const uint8_t *mask        = delta;
+    const uint8_t *values      = (const uint8_t *)delta + mask_size;
+    size_t         values_size = __cstruct_copy_delta_fields(format, &mode, mask, NULL, values);
 
-        total_size += size;
-        i++;
+    if (values_size > delta_size - mask_size)
+    {
+        return -1;
     }
 
-    return total_size;
-}
+    __cstruct_copy_delta_fields(format, &mode, mask, record, values);
 
-// Private Helpers ---------------------------------------------------------------------------------
+    return mask_size + values_size;
+}
 
-static inline bool __cstruct_isdigit(char c)
+ssize_t cstruct_pack_struct(
+    const char   *format,
+    void         *buffer,
+    size_t        buffer_size,
+    const void   *object,
+    const size_t *offsets,
+    size_t        offset_count)
 {
-    return '0' <= c && c <= '9';
+    return __cstruct_transfer_struct(
+        format, buffer, buffer_size, (uint8_t *)object, offsets, offset_count, true);
 }
 
-static int32_t __cstruct_parse_multiplier(const char *format, size_t *i)
+ssize_t cstruct_unpack_struct(
+    const char   *format,
+    const void   *buffer,
+    size_t        buffer_size,
+    void         *object,
+    const size_t *offsets,
+    size_t        offset_count)
 {
-    // NOTE(Caleb):
-    // - Assume that format is not NULL and is not empty, as the calling function should have
-    //   already validated this
-    // - Assume that i is not NULL, as the calling function should have already validated this
+    return __cstruct_transfer_struct(
+        format, (uint8_t *)buffer, buffer_size, object, offsets, offset_count, false);
+}
 
-    if (!__cstruct_isdigit(format[*i]))
+ssize_t cstruct_fields(const char *format, cstruct_field_t *fields, size_t field_capacity)
+{
+    // NOTE(Caleb): Validate the whole format string up front, which also guarantees that no offset
+    // can overflow
+    if (cstruct_sizeof(format) < 0 || (!fields && field_capacity > 0))
     {
-        return 1;
+        return -1;
     }
 
-    int32_t multiplier = 0;
-    do
-    {
-        multiplier = (multiplier * 10) + (format[*i] - '0');
-        (*i)++;
-    } while (__cstruct_isdigit(format[*i]));
+    __cstruct_mode_t mode;
+    __cstruct_parse_mode(format, &mode);
 
-    // NOTE(Caleb):
-    // If the multiplier somehow gets overflowed, just return 0 (invalid format)
-    // I don't intend to support structures with sizes larger than a positive int32_t
-    if (multiplier <= 0)
+    __cstruct_cursor_t cursor;
+    __cstruct_cursor_init(&cursor, format, &mode);
+
+    char    format_char = '\0';
+    int64_t multiplier  = 0;
+    size_t  offset      = 0;
+    size_t  field_count = 0;
+
+    while (__cstruct_cursor_next(&cursor, &format_char, &multiplier) > 0)
+    {
+        size_t size = __cstruct_calculate_size(format_char, multiplier);
+
+        // NOTE(Caleb): Padding and strings are single fields, while other runs are one field per
+        // value
+        size_t width = format_char == 'x' || format_char == 's' ? size : size / multiplier;
+
+        for (size_t j = 0; j < size; j += width)
+        {
+            if (field_count < field_capacity)
+            {
+                fields[field_count].format_char = format_char;
+                fields[field_count].offset      = offset;
+                fields[field_count].size        = width;
+            }
+
+            offset += width;
+            field_count++;
+        }
+    }
+
+    return field_count;
+}
+
+bool cstruct_is_little_endian(const char *format)
+{
+    if (!format || *format == '\0')
+    {
+        return false;
+    }
+
+    __cstruct_mode_t mode;
+    __cstruct_parse_mode(format, &mode);
+
+    return mode.little_endian;
+}
+
+bool cstruct_is_overlay(
+    const char *format, const size_t *offsets, size_t offset_count, size_t object_size)
+{
+    ssize_t packed_size = cstruct_sizeof(format);
+    if (packed_size < 0 || (size_t)packed_size > object_size || (!offsets && offset_count > 0))
+    {
+        return false;
+    }
+
+    __cstruct_mode_t mode;
+    __cstruct_parse_mode(format, &mode);
+
+    if (mode.key || mode.little_endian != __cstruct_host_is_little_endian())
+    {
+        return false;
+    }
+
+    __cstruct_cursor_t cursor;
+    __cstruct_cursor_init(&cursor, format, &mode);
+
+    char    format_char = '\0';
+    int64_t multiplier  = 0;
+    size_t  offset      = 0;
+    size_t  field       = 0;
+
+    while (__cstruct_cursor_next(&cursor, &format_char, &multiplier) > 0)
+    {
+        size_t size = __cstruct_calculate_size(format_char, multiplier);
+
+        // NOTE(Caleb): Padding has no offset, and may lie over a member which isn't packed, so an
+        // overlay zeroes it after the memcpy when packing, and copies around it when unpacking
+        if (format_char == 'x')
+        {
+            offset += size;
+            continue;
+        }
+
+        // NOTE(Caleb): A string is a single value, while every other run is one value per element
+        size_t width = format_char == 's' ? size : size / multiplier;
+
+        for (size_t j = 0; j < size; j += width)
+        {
+            if (field == offset_count || offsets[field] != offset)
+            {
+                return false;
+            }
+
+            offset += width;
+            field++;
+        }
+    }
+
+    return field == offset_count;
+}
+
+ssize_t cstruct_key_search(
+    const char *format, const void *records, size_t count, const void *key, size_t key_size)
+{
+    ssize_t record_size = cstruct_sizeof(format);
+    if (record_size <= 0 || (size_t)record_size < key_size || (!records && count > 0) || !key)
+    {
+        return -1;
+    }
+
+    if (count > SSIZE_MAX / (size_t)record_size)
+    {
+        return -1;
+    }
+
+    // NOTE(Caleb): A lower bound search, which narrows the range to the records after the middle
+    // whenever the middle record is less than the key
+    const uint8_t *base  = records;
+    size_t         first = 0;
+    size_t         n     = count;
+
+    while (n > 0)
+    {
+        size_t half = n / 2;
+
+        if (memcmp(base + (first + half) * (size_t)record_size, key, key_size) < 0)
+        {
+            first += half + 1;
+            n     -= half + 1;
+        }
+        else
+        {
+            n = half;
+        }
+    }
+
+    return first;
+}
+
+// Private Helpers ---------------------------------------------------------------------------------
+
+static inline bool __cstruct_isdigit(char c)
+{
+    return '0' <= c && c <= '9';
+}
+
+static int64_t __cstruct_parse_multiplier(const char *format, size_t *i)
+{
+    // NOTE(Caleb):
+    // - Assume that format is not NULL and is not empty, as the calling function should have
+    //   already validated this
+    // - Assume that i is not NULL, as the calling function should have already validated this
+
+    if (!__cstruct_isdigit(format[*i]))
+    {
+        return 1;
+    }
+
+    int64_t multiplier = 0;
+    do
+    {
+        int digit = format[*i] - '0';
+
+        // NOTE(Caleb): Reject the multiplier before it can overflow, but keep consuming digits so
+        // that the index still ends up past the whole number
+        if (multiplier >= 0 && multiplier <= (INT64_MAX - digit) / 10)
+        {
+            multiplier = (multiplier * 10) + digit;
+        }
+        else
+        {
+            multiplier = -1;
+        }
+
+        (*i)++;
+    } while (__cstruct_isdigit(format[*i]));
+
+    if (multiplier <= 0)
+    {
+        return -1;
+    }
+
+    return multiplier;
+}
+
+static void __cstruct_parse_mode(const char *format, __cstruct_mode_t *mode)
+{
+    // NOTE(Caleb): Assume big endian unless otherwise specified
+    mode->start         = 0;
+    mode->little_endian = false;
+    mode->native        = false;
+    mode->key           = false;
+
+    switch (format[0])
+    {
+        case '<':
+            mode->little_endian = true;
+            mode->start         = 1;
+            break;
+
+        case '^':
+            mode->key = true;
+            // Fallthrough
+
+        case '>':
+        case '!':
+            mode->start = 1;
+            break;
+
+        case '@':
+            mode->native = true;
+            // Fallthrough
+
+        case '=':
+            mode->little_endian = __cstruct_host_is_little_endian();
+            mode->start         = 1;
+            break;
+    }
+}
+
+static inline char __cstruct_native_char(char c, bool native)
+{
+    if (!native || (c != 'l' && c != 'L'))
+    {
+        return c;
+    }
+
+    if (sizeof(long) == 8)
+    {
+        return c == 'l' ? 'q' : 'Q';
+    }
+
+    return c == 'l' ? 'i' : 'I';
+}
+
+static size_t __cstruct_calculate_alignment(char c)
+{
+    switch (c)
+    {
+        case 'h':
+        case 'H':
+            return _Alignof(int16_t);
+
+        case 'i':
+        case 'I':
+            return _Alignof(int32_t);
+
+        case 'q':
+        case 'Q':
+            return _Alignof(int64_t);
+
+        case 'f':
+            return _Alignof(float);
+
+        case 'd':
+            return _Alignof(double);
+
+        default:
+            return 1;
+    }
+}
+
+static inline size_t __cstruct_align(size_t offset, size_t alignment)
+{
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+static void __cstruct_cursor_init(
+    __cstruct_cursor_t *cursor, const char *format, const __cstruct_mode_t *mode)
+{
+    cursor->format       = format;
+    cursor->i            = mode->start;
+    cursor->depth        = 0;
+    cursor->native       = mode->native;
+    cursor->offset       = 0;
+    cursor->pending_char = '\0';
+}
+
+static int __cstruct_cursor_next(
+    __cstruct_cursor_t *cursor, char *format_char, int64_t *multiplier)
+{
+    const char *format = cursor->format;
+
+    // NOTE(Caleb): Produce the format character which was held back by inserted padding
+    if (cursor->pending_char != '\0')
+    {
+        *format_char         = cursor->pending_char;
+        *multiplier          = cursor->pending_multiplier;
+        cursor->pending_char = '\0';
+
+        return 1;
+    }
+
+    while (true)
+    {
+        if (format[cursor->i] == '\0')
+        {
+            // NOTE(Caleb): If true, a group was never closed
+            return cursor->depth == 0 ? 0 : -1;
+        }
+
+        if (format[cursor->i] == ')')
+        {
+            if (cursor->depth == 0)
+            {
+                return -1;
+            }
+
+            // NOTE(Caleb): Under native alignment, each iteration of a group is padded out to the
+            // alignment of the group, just like an element of an array of structs
+            size_t padding = 0;
+            if (cursor->native)
+            {
+                size_t alignment = cursor->groups[cursor->depth - 1].alignment;
+
+                padding         = __cstruct_align(cursor->offset, alignment) - cursor->offset;
+                cursor->offset += padding;
+            }
+
+            // NOTE(Caleb): Jump back to the start of the group until it has run out of iterations
+            if (--cursor->groups[cursor->depth - 1].remaining > 0)
+            {
+                cursor->i = cursor->groups[cursor->depth - 1].start;
+            }
+            else
+            {
+                cursor->depth--;
+                cursor->i++;
+            }
+
+            if (padding > 0)
+            {
+                *format_char = 'x';
+                *multiplier  = padding;
+
+                return 1;
+            }
+
+            continue;
+        }
+
+        int64_t count = __cstruct_parse_multiplier(format, &cursor->i);
+        if (count <= 0)
+        {
+            return -1;
+        }
+
+        if (format[cursor->i] == '(')
+        {
+            // NOTE(Caleb): Empty groups are invalid, as they describe no data
+            if (cursor->depth == __CSTRUCT_MAX_GROUP_DEPTH || format[cursor->i + 1] == ')')
+            {
+                return -1;
+            }
+
+            cursor->i++;
+            cursor->groups[cursor->depth].start     = cursor->i;
+            cursor->groups[cursor->depth].remaining = count;
+            cursor->groups[cursor->depth].alignment = 1;
+            cursor->depth++;
+
+            if (!cursor->native)
+            {
+                continue;
+            }
+
+            // NOTE(Caleb): A group is aligned to the largest alignment of any value inside it
+            size_t  end        = cursor->i;
+            size_t  alignment  = 1;
+            ssize_t group_size = __cstruct_sizeof_group(
+                format, &end, cursor->depth, cursor->native, &alignment);
+            if (group_size <= 0 || format[end] != ')')
+            {
+                return -1;
+            }
+
+            size_t padding = __cstruct_align(cursor->offset, alignment) - cursor->offset;
+
+            cursor->groups[cursor->depth - 1].alignment  = alignment;
+            cursor->offset                              += padding;
+
+            if (padding > 0)
+            {
+                *format_char = 'x';
+                *multiplier  = padding;
+
+                return 1;
+            }
+
+            continue;
+        }
+
+        *format_char = __cstruct_native_char(format[cursor->i], cursor->native);
+        *multiplier  = count;
+        cursor->i++;
+
+        if (!cursor->native)
+        {
+            return 1;
+        }
+
+        // NOTE(Caleb): Under native alignment, each value is aligned to its own alignment, and so
+        // is every value of a run, as the size of a type is a multiple of its alignment
+        ssize_t size    = __cstruct_calculate_size(*format_char, count);
+        size_t  padding = __cstruct_align(
+            cursor->offset, __cstruct_calculate_alignment(*format_char)) - cursor->offset;
+
+        cursor->offset += padding + (size > 0 ? size : 0);
+
+        if (padding > 0)
+        {
+            cursor->pending_char       = *format_char;
+            cursor->pending_multiplier = count;
+
+            *format_char = 'x';
+            *multiplier  = padding;
+        }
+
+        return 1;
+    }
+}
+
+static ssize_t __cstruct_sizeof_group(
+    const char *format, size_t *i, size_t depth, bool native, size_t *alignment)
+{
+    ssize_t total_size = 0;
+
+    *alignment = 1;
+
+    while (format[*i] != '\0' && format[*i] != ')')
+    {
+        int64_t multiplier = __cstruct_parse_multiplier(format, i);
+        if (multiplier <= 0)
+        {
+            return -1;
+        }
+
+        ssize_t size              = 0;
+        size_t  element_alignment = 1;
+
+        if (format[*i] == '(')
+        {
+            if (depth + 1 > __CSTRUCT_MAX_GROUP_DEPTH)
+            {
+                return -1;
+            }
+
+            (*i)++;
+
+            // NOTE(Caleb): The size of a group is computed once and then scaled by its repeat
+            // count, rather than walking every iteration
+            ssize_t group_size =
+                __cstruct_sizeof_group(format, i, depth + 1, native, &element_alignment);
+            if (group_size <= 0 || format[*i] != ')')
+            {
+                return -1;
+            }
+
+            // NOTE(Caleb): Under native alignment, every iteration is padded out to the alignment
+            // of the group
+            if ((size_t)group_size > SSIZE_MAX - element_alignment)
+            {
+                return -1;
+            }
+
+            group_size = __cstruct_align(group_size, element_alignment);
+            if (group_size > SSIZE_MAX / multiplier)
+            {
+                return -1;
+            }
+
+            size = group_size * multiplier;
+        }
+        else
+        {
+            // NOTE(Caleb): At this point, format[*i] is the next format character
+            char format_char = __cstruct_native_char(format[*i], native);
+
+            size = __cstruct_calculate_size(format_char, multiplier);
+            if (size <= 0)
+            {
+                return -1;
+            }
+
+            if (native)
+            {
+                element_alignment = __cstruct_calculate_alignment(format_char);
+            }
+        }
+
+        if ((size_t)total_size > SSIZE_MAX - element_alignment)
+        {
+            return -1;
+        }
+
+        total_size = __cstruct_align(total_size, element_alignment);
+
+        if (total_size > SSIZE_MAX - size)
+        {
+            return -1;
+        }
+
+        if (element_alignment > *alignment)
+        {
+            *alignment = element_alignment;
+        }
+
+        total_size += size;
+        (*i)++;
+    }
+
+    return total_size;
+}
+
+static ssize_t __cstruct_count_fields(const char *format, const __cstruct_mode_t *mode)
+{
+    __cstruct_cursor_t cursor;
+    __cstruct_cursor_init(&cursor, format, mode);
+
+    char    format_char = '\0';
+    int64_t multiplier  = 0;
+    int     status      = 0;
+    ssize_t field_count = 0;
+
+    while ((status = __cstruct_cursor_next(&cursor, &format_char, &multiplier)) > 0)
+    {
+        if (__cstruct_calculate_size(format_char, multiplier) <= 0)
+        {
+            return -1;
+        }
+
+        if (format_char == 's')
+        {
+            field_count++;
+        }
+        else if (format_char != 'x')
+        {
+            field_count += multiplier;
+        }
+    }
+
+    return status < 0 ? -1 : field_count;
+}
+
+static size_t __cstruct_copy_delta_fields(
+    const char             *format,
+    const __cstruct_mode_t *mode,
+    const uint8_t          *mask,
+    uint8_t                *record,
+    const uint8_t          *values)
+{
+    __cstruct_cursor_t cursor;
+    __cstruct_cursor_init(&cursor, format, mode);
+
+    char    format_char = '\0';
+    int64_t multiplier  = 0;
+    size_t  values_size = 0;
+    size_t  offset      = 0;
+    size_t  field       = 0;
+
+    while (__cstruct_cursor_next(&cursor, &format_char, &multiplier) > 0)
+    {
+        size_t size = __cstruct_calculate_size(format_char, multiplier);
+
+        if (format_char == 'x')
+        {
+            offset += size;
+            continue;
+        }
+
+        // NOTE(Caleb): A string is a single field, while every other run is one field per value
+        size_t width = format_char == 's' ? size : size / multiplier;
+
+        for (size_t j = 0; j < size; j += width)
+        {
+            if (mask[field / 8] & (1 << (field % 8)))
+            {
+                if (record)
+                {
+                    memcpy(record + offset, values + values_size, width);
+                }
+
+                values_size += width;
+            }
+
+            offset += width;
+            field++;
+        }
+    }
+
+    return values_size;
+}
+
+static ssize_t __cstruct_calculate_size(char c, int64_t multiplier)
+{
+    ssize_t size = 0;
+
+    switch (c)
+    {
+        case 'x':
+        case 'b':
+        case 'B':
+        case 's':
+            size = 1;
+            break;
+
+        case 'h':
+        case 'H':
+            size = 2;
+            break;
+
+        case 'i':
+        case 'I':
+        case 'l':
+        case 'L':
+        case 'f':
+            size = 4;
+            break;
+
+        case 'q':
+        case 'Q':
+        case 'd':
+            size = 8;
+            break;
+
+        default:
+            return -1;
+    }
+
+    if (multiplier > SSIZE_MAX / size)
+    {
+        return -1;
+    }
+
+    return size * multiplier;
+}
+
+static inline bool __cstruct_host_is_little_endian(void)
+{
+    const uint16_t x = 1;
+
+    uint8_t data = 0;
+    memcpy(&data, &x, 1);
+
+    return data == 1;
+}
+
+static void __cstruct_swap_run(uint8_t *data, size_t width, size_t n)
+{
+    size_t size = width * n;
+    size_t i    = 0;
+
+#if defined(__SSE2__)
+    // NOTE(Caleb):
+    // - Each 16 byte lane holds whole elements, since 16 is a multiple of every element width
+    // - Reverse the 16-bit words within each element, then swap the bytes within each word
+    for (; i + 16 <= size; i += 16)
     {
-        return -1;
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+
+        if (width == 4)
+        {
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+            v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        }
+        else if (width == 8)
+        {
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+            v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+        }
+
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i *)(data + i), v);
     }
+#endif
 
-    return multiplier;
+    for (; i < size; i += width)
+    {
+        for (size_t lo = i, hi = i + width - 1; lo < hi; lo++, hi--)
+        {
+            uint8_t tmp = data[lo];
+            data[lo]    = data[hi];
+            data[hi]    = tmp;
+        }
+    }
 }
 
-static ssize_t __cstruct_calculate_size(char c, int multiplier)
+static void __cstruct_swap_records(
+    const char             *format,
+    const __cstruct_mode_t *mode,
+    uint8_t                *records,
+    size_t                  record_size,
+    size_t                  count)
 {
-    ssize_t size = 0;
+    __cstruct_cursor_t cursor;
+    __cstruct_cursor_init(&cursor, format, mode);
 
-    switch (c)
+    size_t offset     = 0;
+    size_t run_offset = 0;
+    size_t run_width  = 0;
+    size_t run_length = 0;
+
+    // NOTE(Caleb): Adjacent fields of the same width are merged into a single run, so that e.g.
+    // "HHH" and "3H" are both swapped with one call
+    while (true)
+    {
+        char    format_char = '\0';
+        int64_t multiplier  = 0;
+        size_t  width       = 0;
+
+        if (__cstruct_cursor_next(&cursor, &format_char, &multiplier) > 0)
+        {
+            width = __cstruct_calculate_size(format_char, 1);
+        }
+
+        // NOTE(Caleb): Single byte fields ('b', 'B', 's', and 'x') never need to be swapped
+        bool swappable = width > 1;
+
+        if (swappable && width == run_width && offset == run_offset + run_width * run_length)
+        {
+            run_length += multiplier;
+            offset     += width * multiplier;
+
+            continue;
+        }
+
+        if (run_length > 0)
+        {
+            // NOTE(Caleb): If true, the run spans entire records, so every record in the block can
+            // be swapped as one long run
+            if (run_offset == 0 && run_width * run_length == record_size)
+            {
+                __cstruct_swap_run(records, run_width, run_length * count);
+            }
+            else
+            {
+                for (size_t j = 0; j < count; j++)
+                {
+                    uint8_t *record = records + j * record_size;
+                    __cstruct_swap_run(record + run_offset, run_width, run_length);
+                }
+            }
+        }
+
+        if (width == 0)
+        {
+            break;
+        }
+
+        run_offset = offset;
+        run_width  = swappable ? width : 0;
+        run_length = swappable ? multiplier : 0;
+
+        offset += width * multiplier;
+    }
+}
+
+static void __cstruct_select_packers(const __cstruct_mode_t *mode, __cstruct_packers_t *packers)
+{
+    // NOTE(Caleb):
+    // - Select packing functions here to avoid unnecessary branching in the packing loop
+    // - Assume big endian unless otherwise specified
+    packers->pack16      = __cstruct_pack_be16;
+    packers->pack32      = __cstruct_pack_be32;
+    packers->pack64      = __cstruct_pack_be64;
+    packers->pack_float  = __cstruct_pack_float_be;
+    packers->pack_double = __cstruct_pack_double_be;
+
+    if (mode->little_endian)
+    {
+        packers->pack16      = __cstruct_pack_le16;
+        packers->pack32      = __cstruct_pack_le32;
+        packers->pack64      = __cstruct_pack_le64;
+        packers->pack_float  = __cstruct_pack_float_le;
+        packers->pack_double = __cstruct_pack_double_le;
+    }
+}
+
+static inline ssize_t __cstruct_pack_value(
+    char format_char, uint8_t *dest, va_list *args, const __cstruct_packers_t *packers)
+{
+    switch (format_char)
     {
-        case 'x':
         case 'b':
         case 'B':
-        case 's':
-            size = 1;
-            break;
+        {
+            uint8_t x = (uint8_t)va_arg(*args, int);
+            memcpy(dest, &x, 1);
+
+            return 1;
+        }
 
         case 'h':
         case 'H':
-            size = 2;
-            break;
+        {
+            uint16_t x = (uint16_t)va_arg(*args, int);
+            x          = packers->pack16(x);
+
+            memcpy(dest, &x, 2);
+
+            return 2;
+        }
 
         case 'i':
         case 'I':
         case 'l':
         case 'L':
+        {
+            uint32_t x = (uint32_t)va_arg(*args, int);
+            x          = packers->pack32(x);
+
+            memcpy(dest, &x, 4);
+
+            return 4;
+        }
+
+        case 'q':
+        case 'Q':
+        {
+            uint64_t x = (uint64_t)va_arg(*args, uint64_t);
+            x          = packers->pack64(x);
+
+            memcpy(dest, &x, 8);
+
+            return 8;
+        }
+
         case 'f':
-            size = 4;
+        {
+            float    f = (float)va_arg(*args, double);
+            uint32_t u = packers->pack_float(f);
+
+            memcpy(dest, &u, 4);
+
+            return 4;
+        }
+
+        case 'd':
+        {
+            double   d = (double)va_arg(*args, double);
+            uint64_t u = packers->pack_double(d);
+
+            memcpy(dest, &u, 8);
+
+            return 8;
+        }
+
+        default:
+            return -1;
+    }
+}
+
+static inline void __cstruct_convert_value(
+    size_t width, const uint8_t *src, uint8_t *dest, const __cstruct_packers_t *packers)
+{
+    // NOTE(Caleb): Converting between the host and packed byte orders is the same reversal in
+    // either direction, so the packing functions serve for unpacking as well
+    switch (width)
+    {
+        case 1:
+        {
+            *dest = *src;
+            break;
+        }
+
+        case 2:
+        {
+            uint16_t x = 0;
+            memcpy(&x, src, 2);
+
+            x = packers->pack16(x);
+            memcpy(dest, &x, 2);
+
+            break;
+        }
+
+        case 4:
+        {
+            uint32_t x = 0;
+            memcpy(&x, src, 4);
+
+            x = packers->pack32(x);
+            memcpy(dest, &x, 4);
+
+            break;
+        }
+
+        case 8:
+        {
+            uint64_t x = 0;
+            memcpy(&x, src, 8);
+
+            x = packers->pack64(x);
+            memcpy(dest, &x, 8);
+
+            break;
+        }
+    }
+}
+
+static inline void __cstruct_transform_key(char format_char, uint8_t *value, bool encode)
+{
+    switch (format_char)
+    {
+        case 'b':
+        case 'h':
+        case 'i':
+        case 'l':
+        case 'q':
+        {
+            value[0] ^= 0x80;
+            break;
+        }
+
+        case 'f':
+        case 'd':
+        {
+            // NOTE(Caleb): Negative values are flipped entirely so that larger magnitudes sort
+            // lower. Encoded, the sign bit is set for positive values rather than negative ones.
+            bool   negative = encode ? (value[0] & 0x80) : !(value[0] & 0x80);
+            size_t width    = format_char == 'f' ? 4 : 8;
+
+            if (!negative)
+            {
+                value[0] ^= 0x80;
+                break;
+            }
+
+            for (size_t j = 0; j < width; j++)
+            {
+                value[j] = ~value[j];
+            }
+
             break;
+        }
+    }
+}
+
+static inline void __cstruct_store_run(uint8_t *dest, const uint8_t *src, size_t size)
+{
+    if (size >= CSTRUCT_STREAM_THRESHOLD)
+    {
+        __cstruct_stream_run(dest, src, size);
+    }
+    else if (src)
+    {
+        memcpy(dest, src, size);
+    }
+    else
+    {
+        memset(dest, 0, size);
+    }
+}
+
+static void __cstruct_stream_run(uint8_t *dest, const uint8_t *src, size_t size)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // NOTE(Caleb): Non-temporal stores must be aligned, so bytes up to the first 16 byte boundary
+    // are stored normally
+    i = (16 - ((uintptr_t)dest & 15)) & 15;
+    i = i < size ? i : size;
+
+    if (src)
+    {
+        memcpy(dest, src, i);
+
+        for (; i + 16 <= size; i += 16)
+        {
+            _mm_stream_si128((__m128i *)(dest + i), _mm_loadu_si128((const __m128i *)(src + i)));
+        }
+    }
+    else
+    {
+        memset(dest, 0, i);
+
+        for (; i + 16 <= size; i += 16)
+        {
+            _mm_stream_si128((__m128i *)(dest + i), _mm_setzero_si128());
+        }
+    }
+
+    // NOTE(Caleb): Non-temporal stores are weakly ordered, so make them visible before any store
+    // which follows
+    _mm_sfence();
+#endif
+
+    if (src)
+    {
+        memcpy(dest + i, src + i, size - i);
+    }
+    else
+    {
+        memset(dest + i, 0, size - i);
+    }
+}
+
+static void __cstruct_swap_copy_run(uint8_t *dest, const uint8_t *src, size_t width, size_t size)
+{
+    uint8_t chunk[__CSTRUCT_CHUNK_SIZE];
+    bool    stream = size >= CSTRUCT_STREAM_THRESHOLD;
+
+    // NOTE(Caleb): The chunk size is a multiple of every element width, so no element is split
+    // between two chunks. Long runs are swapped in a buffer which stays in cache, and only then
+    // streamed out.
+    for (size_t offset = 0; offset < size; offset += __CSTRUCT_CHUNK_SIZE)
+    {
+        size_t   n  = size - offset < __CSTRUCT_CHUNK_SIZE ? size - offset : __CSTRUCT_CHUNK_SIZE;
+        uint8_t *to = stream ? chunk : dest + offset;
+
+        memcpy(to, src + offset, n);
+        __cstruct_swap_run(to, width, n / width);
+
+        if (stream)
+        {
+            __cstruct_stream_run(dest + offset, chunk, n);
+        }
+    }
+}
+
+static ssize_t __cstruct_transfer_struct(
+    const char   *format,
+    uint8_t      *packed,
+    size_t        packed_size,
+    uint8_t      *object,
+    const size_t *offsets,
+    size_t        offset_count,
+    bool          pack)
+{
+    if (!format || *format == '\0' || !packed || !object || (!offsets && offset_count > 0))
+    {
+        return -1;
+    }
+
+    __cstruct_mode_t mode;
+    __cstruct_parse_mode(format, &mode);
+
+    __cstruct_packers_t packers;
+    __cstruct_select_packers(&mode, &packers);
+
+    __cstruct_cursor_t cursor;
+    __cstruct_cursor_init(&cursor, format, &mode);
+
+    char    format_char = '\0';
+    int64_t multiplier  = 0;
+    int     status      = 0;
+    size_t  total_size  = 0;
+    size_t  field       = 0;
+
+    while ((status = __cstruct_cursor_next(&cursor, &format_char, &multiplier)) > 0)
+    {
+        ssize_t size = __cstruct_calculate_size(format_char, multiplier);
+        if (size <= 0)
+        {
+            return -1;
+        }
+
+        // NOTE(Caleb): If true, the blob is too small to hold the next value
+        if (total_size + size > packed_size)
+        {
+            return -1;
+        }
+
+        uint8_t *blob = packed + total_size;
+
+        if (format_char == 'x')
+        {
+            if (pack)
+            {
+                __cstruct_store_run(blob, NULL, size);
+            }
+        }
+        else if (format_char == 's')
+        {
+            if (field == offset_count)
+            {
+                return -1;
+            }
+
+            uint8_t *member = object + offsets[field++];
+            __cstruct_store_run(pack ? blob : member, pack ? member : blob, size);
+        }
+        else
+        {
+            size_t width      = size / multiplier;
+            bool   contiguous = !mode.key && multiplier > 1;
+
+            contiguous = contiguous && offset_count - field >= (size_t)multiplier;
+
+            // NOTE(Caleb): A run of values laid out one after another in the struct, such as an
+            // array member, is converted as a whole rather than one value at a time
+            for (int64_t j = 1; contiguous && j < multiplier; j++)
+            {
+                contiguous = offsets[field + j] == offsets[field] + j * width;
+            }
+
+            if (contiguous)
+            {
+                uint8_t *member = object + offsets[field];
+                uint8_t *dest   = pack ? blob : member;
+                uint8_t *src    = pack ? member : blob;
+
+                if (width == 1 || mode.little_endian == __cstruct_host_is_little_endian())
+                {
+                    __cstruct_store_run(dest, src, size);
+                }
+                else
+                {
+                    __cstruct_swap_copy_run(dest, src, width, size);
+                }
+
+                field      += multiplier;
+                total_size += size;
+
+                continue;
+            }
+
+            for (ssize_t j = 0; j < size; j += width)
+            {
+                if (field == offset_count)
+                {
+                    return -1;
+                }
+
+                uint8_t *member = object + offsets[field++];
+                if (pack)
+                {
+                    __cstruct_convert_value(width, member, blob + j, &packers);
+
+                    if (mode.key)
+                    {
+                        __cstruct_transform_key(format_char, blob + j, true);
+                    }
+                }
+                else if (mode.key)
+                {
+                    uint8_t key[8];
+                    memcpy(key, blob + j, width);
+
+                    __cstruct_transform_key(format_char, key, false);
+                    __cstruct_convert_value(width, key, member, &packers);
+                }
+                else
+                {
+                    __cstruct_convert_value(width, blob + j, member, &packers);
+                }
+            }
+        }
 
-        case 'q':
-        case 'Q':
-        case 'd':
-            size = 8;
-            break;
+        total_size += size;
+    }
 
-        default:
-            return -1;
+    // NOTE(Caleb): If true, there are more offsets than values, so the offsets are for some other
+    // format string
+    if (status < 0 || field != offset_count)
+    {
+        return -1;
     }
 
-    return size * multiplier;
+    return total_size;
 }
 
 static inline uint16_t __cstruct_pack_be16(uint16_t x)
@@ -706,3 +2162,505 @@ static inline double __cstruct_unpack_double_le(uint64_t x)
 
     return y;
 }
+
+static inline uint8_t __cstruct_pack_8(uint8_t x)
+{
+    return x;
+}
+
+static inline uint8_t __cstruct_pack_key8(uint8_t x)
+{
+    return x ^ 0x80;
+}
+
+static inline uint8_t __cstruct_unpack_8(uint8_t x)
+{
+    return x;
+}
+
+static inline uint8_t __cstruct_unpack_key8(uint8_t x)
+{
+    return x ^ 0x80;
+}
+
+static inline uint16_t __cstruct_pack_key16(uint16_t x)
+{
+    return __cstruct_pack_be16(x ^ 0x8000);
+}
+
+static inline uint16_t __cstruct_unpack_key16(uint16_t x)
+{
+    return __cstruct_unpack_be16(x) ^ 0x8000;
+}
+
+static inline uint32_t __cstruct_pack_key32(uint32_t x)
+{
+    return __cstruct_pack_be32(x ^ 0x80000000);
+}
+
+static inline uint32_t __cstruct_unpack_key32(uint32_t x)
+{
+    return __cstruct_unpack_be32(x) ^ 0x80000000;
+}
+
+static inline uint64_t __cstruct_pack_key64(uint64_t x)
+{
+    return __cstruct_pack_be64(x ^ 0x8000000000000000ULL);
+}
+
+static inline uint64_t __cstruct_unpack_key64(uint64_t x)
+{
+    return __cstruct_unpack_be64(x) ^ 0x8000000000000000ULL;
+}
+
+static inline uint32_t __cstruct_pack_float_key(float x)
+{
+    uint32_t y = 0;
+    memcpy(&y, &x, sizeof(float));
+
+    // NOTE(Caleb): Negative values are flipped entirely, so that larger magnitudes sort lower
+    y = (y & 0x80000000) ? ~y : y ^ 0x80000000;
+
+    return __cstruct_pack_be32(y);
+}
+
+static inline float __cstruct_unpack_float_key(uint32_t x)
+{
+    uint32_t y = __cstruct_unpack_be32(x);
+    y          = (y & 0x80000000) ? y ^ 0x80000000 : ~y;
+
+    float z = 0;
+    memcpy(&z, &y, sizeof(float));
+
+    return z;
+}
+
+static inline uint64_t __cstruct_pack_double_key(double x)
+{
+    uint64_t y = 0;
+    memcpy(&y, &x, sizeof(double));
+
+    y = (y & 0x8000000000000000ULL) ? ~y : y ^ 0x8000000000000000ULL;
+
+    return __cstruct_pack_be64(y);
+}
+
+static inline double __cstruct_unpack_double_key(uint64_t x)
+{
+    uint64_t y = __cstruct_unpack_be64(x);
+    y          = (y & 0x8000000000000000ULL) ? y ^ 0x8000000000000000ULL : ~y;
+
+    double z = 0;
+    memcpy(&z, &y, sizeof(double));
+
+    return z;
+}
+
+static int __cstruct_decode_ops(
+    __cstruct_cursor_t *cursor, const __cstruct_mode_t *mode, __cstruct_op_t *ops, size_t *size)
+{
+    const __cstruct_op_info_t *table = __cstruct_op_table[mode->key ? 2 : mode->little_endian];
+
+    const char *format      = cursor->format;
+    char        format_char = '\0';
+    int64_t     multiplier  = 0;
+    int         status      = 1;
+    size_t      count       = 0;
+
+    *size = 0;
+
+    while (count < __CSTRUCT_OP_BATCH_SIZE)
+    {
+        size_t        i = cursor->i;
+        int64_t       m = __cstruct_parse_multiplier(format, &i);
+        unsigned char c = format[i];
+
+        // NOTE(Caleb): A run of a format character needs no help from the cursor, unless padding
+        // may have to be inserted before it. Groups and the end of the format string are left to
+        // the cursor, as parentheses and the terminator are invalid format characters.
+        if (!cursor->native && m > 0 && c < 128 && table[c].width != 0)
+        {
+            format_char = c;
+            multiplier  = m;
+            cursor->i   = i + 1;
+        }
+        else if ((status = __cstruct_cursor_next(cursor, &format_char, &multiplier)) <= 0)
+        {
+            break;
+        }
+
+        c = format_char;
+        if (c >= 128 || table[c].width == 0)
+        {
+            return -1;
+        }
+
+        // NOTE(Caleb): Padding and strings count bytes, while other runs count values. Each string
+        // takes its own argument, so strings are never merged.
+        __cstruct_op_info_t info = table[c];
+
+        // NOTE(Caleb): If true, the batch would cover more bytes than a ssize_t can count
+        if ((size_t)multiplier > (SSIZE_MAX - *size) / info.width)
+        {
+            return -1;
+        }
+
+        size_t run_size = (size_t)info.width * multiplier;
+        size_t n        = info.width == 1 ? run_size : (size_t)multiplier;
+
+        if (count > 0 && ops[count - 1].opcode == info.opcode && c != 's')
+        {
+            ops[count - 1].count += n;
+        }
+        else
+        {
+            ops[count].count  = n;
+            ops[count].opcode = info.opcode;
+            count++;
+        }
+
+        *size += run_size;
+    }
+
+    ops[count].count  = 0;
+    ops[count].opcode = __CSTRUCT_OP_END;
+
+    if (status < 0)
+    {
+        return -1;
+    }
+
+    return count > 0 ? 1 : 0;
+}
+
+// NOTE(Caleb): Each handler runs one operation, then moves on to the next; under computed gotos,
+// every handler ends in its own indirect jump, which predicts far better than a single switch
+#if defined(__CSTRUCT_HAVE_COMPUTED_GOTO)
+#define __CSTRUCT_OP_LABEL(name) [__CSTRUCT_OP_##name] = &&__cstruct_op_##name,
+#define __CSTRUCT_OP_HANDLER(name) __cstruct_op_##name
+#define __CSTRUCT_NEXT_OP() goto *labels[(++op)->opcode]
+#else
+#define __CSTRUCT_OP_HANDLER(name) case __CSTRUCT_OP_##name
+#define __CSTRUCT_NEXT_OP()                                                                        \
+    op++;                                                                                          \
+    continue
+#endif
+
+// NOTE(Caleb): Pack a run of values taken from the argument list as arg_type, each converted from
+// value_type to its packed bits by convert
+#define __CSTRUCT_PACK_RUN(bits_type, value_type, arg_type, convert)                               \
+    for (size_t n = 0; n < op->count; n++)                                                         \
+    {                                                                                              \
+        bits_type x = convert((value_type)va_arg(*args, arg_type));                                \
+        memcpy(dest, &x, sizeof(x));                                                               \
+        dest += sizeof(x);                                                                         \
+    }
+
+// NOTE(Caleb): Unpack a run of values into pointers to value_type taken from the argument list,
+// each converted from its packed bits by convert
+#define __CSTRUCT_UNPACK_RUN(bits_type, value_type, convert)                                       \
+    for (size_t n = 0; n < op->count; n++)                                                         \
+    {                                                                                              \
+        bits_type x = 0;                                                                           \
+        memcpy(&x, src, sizeof(x));                                                                \
+        *va_arg(*args, value_type *) = convert(x);                                                 \
+        src += sizeof(x);                                                                          \
+    }
+
+// NOTE(Caleb): Computed gotos are a GNU extension
+#if defined(__CSTRUCT_HAVE_COMPUTED_GOTO)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+static void __cstruct_run_pack(const __cstruct_op_t *op, uint8_t *dest, va_list *args)
+{
+#if defined(__CSTRUCT_HAVE_COMPUTED_GOTO)
+    static void *const labels[__CSTRUCT_OP_COUNT] = {__CSTRUCT_OPS(__CSTRUCT_OP_LABEL)};
+
+    goto *labels[op->opcode];
+#else
+    while (true)
+    {
+        switch (op->opcode)
+        {
+#endif
+
+    __CSTRUCT_OP_HANDLER(END):
+    {
+        return;
+    }
+
+    __CSTRUCT_OP_HANDLER(PAD):
+    {
+        __cstruct_store_run(dest, NULL, op->count);
+        dest += op->count;
+
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(STRING):
+    {
+        // NOTE(Caleb): A NULL string packs as all zeroes
+        __cstruct_store_run(dest, va_arg(*args, const uint8_t *), op->count);
+        dest += op->count;
+
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(8):
+    {
+        __CSTRUCT_PACK_RUN(uint8_t, uint8_t, int, __cstruct_pack_8);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(KEY8):
+    {
+        __CSTRUCT_PACK_RUN(uint8_t, uint8_t, int, __cstruct_pack_key8);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(BE16):
+    {
+        __CSTRUCT_PACK_RUN(uint16_t, uint16_t, int, __cstruct_pack_be16);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(LE16):
+    {
+        __CSTRUCT_PACK_RUN(uint16_t, uint16_t, int, __cstruct_pack_le16);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(KEY16):
+    {
+        __CSTRUCT_PACK_RUN(uint16_t, uint16_t, int, __cstruct_pack_key16);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(BE32):
+    {
+        __CSTRUCT_PACK_RUN(uint32_t, uint32_t, int, __cstruct_pack_be32);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(LE32):
+    {
+        __CSTRUCT_PACK_RUN(uint32_t, uint32_t, int, __cstruct_pack_le32);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(KEY32):
+    {
+        __CSTRUCT_PACK_RUN(uint32_t, uint32_t, int, __cstruct_pack_key32);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(BE64):
+    {
+        __CSTRUCT_PACK_RUN(uint64_t, uint64_t, uint64_t, __cstruct_pack_be64);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(LE64):
+    {
+        __CSTRUCT_PACK_RUN(uint64_t, uint64_t, uint64_t, __cstruct_pack_le64);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(KEY64):
+    {
+        __CSTRUCT_PACK_RUN(uint64_t, uint64_t, uint64_t, __cstruct_pack_key64);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(BE_FLOAT):
+    {
+        __CSTRUCT_PACK_RUN(uint32_t, float, double, __cstruct_pack_float_be);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(LE_FLOAT):
+    {
+        __CSTRUCT_PACK_RUN(uint32_t, float, double, __cstruct_pack_float_le);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(KEY_FLOAT):
+    {
+        __CSTRUCT_PACK_RUN(uint32_t, float, double, __cstruct_pack_float_key);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(BE_DOUBLE):
+    {
+        __CSTRUCT_PACK_RUN(uint64_t, double, double, __cstruct_pack_double_be);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(LE_DOUBLE):
+    {
+        __CSTRUCT_PACK_RUN(uint64_t, double, double, __cstruct_pack_double_le);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(KEY_DOUBLE):
+    {
+        __CSTRUCT_PACK_RUN(uint64_t, double, double, __cstruct_pack_double_key);
+        __CSTRUCT_NEXT_OP();
+    }
+
+#if !defined(__CSTRUCT_HAVE_COMPUTED_GOTO)
+            default:
+                return;
+        }
+    }
+#endif
+}
+
+static void __cstruct_run_unpack(const __cstruct_op_t *op, const uint8_t *src, va_list *args)
+{
+#if defined(__CSTRUCT_HAVE_COMPUTED_GOTO)
+    static void *const labels[__CSTRUCT_OP_COUNT] = {__CSTRUCT_OPS(__CSTRUCT_OP_LABEL)};
+
+    goto *labels[op->opcode];
+#else
+    while (true)
+    {
+        switch (op->opcode)
+        {
+#endif
+
+    __CSTRUCT_OP_HANDLER(END):
+    {
+        return;
+    }
+
+    __CSTRUCT_OP_HANDLER(PAD):
+    {
+        src += op->count;
+
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(STRING):
+    {
+        __cstruct_store_run(va_arg(*args, uint8_t *), src, op->count);
+        src += op->count;
+
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(8):
+    {
+        __CSTRUCT_UNPACK_RUN(uint8_t, uint8_t, __cstruct_unpack_8);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(KEY8):
+    {
+        __CSTRUCT_UNPACK_RUN(uint8_t, uint8_t, __cstruct_unpack_key8);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(BE16):
+    {
+        __CSTRUCT_UNPACK_RUN(uint16_t, uint16_t, __cstruct_unpack_be16);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(LE16):
+    {
+        __CSTRUCT_UNPACK_RUN(uint16_t, uint16_t, __cstruct_unpack_le16);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(KEY16):
+    {
+        __CSTRUCT_UNPACK_RUN(uint16_t, uint16_t, __cstruct_unpack_key16);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(BE32):
+    {
+        __CSTRUCT_UNPACK_RUN(uint32_t, uint32_t, __cstruct_unpack_be32);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(LE32):
+    {
+        __CSTRUCT_UNPACK_RUN(uint32_t, uint32_t, __cstruct_unpack_le32);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(KEY32):
+    {
+        __CSTRUCT_UNPACK_RUN(uint32_t, uint32_t, __cstruct_unpack_key32);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(BE64):
+    {
+        __CSTRUCT_UNPACK_RUN(uint64_t, uint64_t, __cstruct_unpack_be64);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(LE64):
+    {
+        __CSTRUCT_UNPACK_RUN(uint64_t, uint64_t, __cstruct_unpack_le64);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(KEY64):
+    {
+        __CSTRUCT_UNPACK_RUN(uint64_t, uint64_t, __cstruct_unpack_key64);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(BE_FLOAT):
+    {
+        __CSTRUCT_UNPACK_RUN(uint32_t, float, __cstruct_unpack_float_be);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(LE_FLOAT):
+    {
+        __CSTRUCT_UNPACK_RUN(uint32_t, float, __cstruct_unpack_float_le);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(KEY_FLOAT):
+    {
+        __CSTRUCT_UNPACK_RUN(uint32_t, float, __cstruct_unpack_float_key);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(BE_DOUBLE):
+    {
+        __CSTRUCT_UNPACK_RUN(uint64_t, double, __cstruct_unpack_double_be);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(LE_DOUBLE):
+    {
+        __CSTRUCT_UNPACK_RUN(uint64_t, double, __cstruct_unpack_double_le);
+        __CSTRUCT_NEXT_OP();
+    }
+
+    __CSTRUCT_OP_HANDLER(KEY_DOUBLE):
+    {
+        __CSTRUCT_UNPACK_RUN(uint64_t, double, __cstruct_unpack_double_key);
+        __CSTRUCT_NEXT_OP();
+    }
+
+#if !defined(__CSTRUCT_HAVE_COMPUTED_GOTO)
+            default:
+                return;
+        }
+    }
+#endif
+}
+
+#if defined(__CSTRUCT_HAVE_COMPUTED_GOTO)
+#pragma GCC diagnostic pop
+#endif
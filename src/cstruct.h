@@ -1,8 +1,23 @@
 #pragma once
 
+#include <stdarg.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <sys/types.h>
 
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// A single field of a packed blob, as described by a format string.
+typedef struct
+{
+    char   format_char; // The format character of the field
+    size_t offset;      // The offset of the field within the packed blob
+    size_t size;        // The size of the field in bytes
+} cstruct_field_t;
+
 /// Pack values into a binary blob according to the format string.
 /// @param[in] format The format string describing the data layout.
 /// @param[out] buffer The buffer to pack the data into.
@@ -19,7 +34,146 @@ ssize_t cstruct_pack(const char *format, void *buffer, size_t buffer_size, ...);
 /// @return The number of bytes unpacked, or -1 if an error occurred.
 ssize_t cstruct_unpack(const char *format, const void *buffer, size_t buffer_size, ...);
 
+/// Pack values into a binary blob according to the format string.
+/// @param[in] format The format string describing the data layout.
+/// @param[out] buffer The buffer to pack the data into.
+/// @param[in] buffer_size The length of the buffer.
+/// @param[in] ap The values to pack, corresponding to the format string.
+/// @return The number of bytes packed, or -1 if an error occurred.
+ssize_t cstruct_vpack(const char *format, void *buffer, size_t buffer_size, va_list ap);
+
+/// Unpack values from a binary blob according to the format string.
+/// @param[in] format The format string describing the data layout.
+/// @param[in] buffer The buffer to unpack the data from.
+/// @param[in] buffer_size The length of the buffer.
+/// @param[out] ap Pointers to variables where the unpacked values will be stored.
+/// @return The number of bytes unpacked, or -1 if an error occurred.
+ssize_t cstruct_vunpack(const char *format, const void *buffer, size_t buffer_size, va_list ap);
+
 /// Return the size of a packed struct given its format string.
 /// @param[in] format The format string.
 /// @return The size of the packed struct, or -1 if the format string is invalid.
 ssize_t cstruct_sizeof(const char *format);
+
+/// Convert the byte order of packed records in place, between the format's byte order and the
+/// host's native byte order.
+/// @param[in] format The format string describing the layout of a single record.
+/// @param[inout] buffer The buffer holding the packed records.
+/// @param[in] buffer_size The length of the buffer.
+/// @param[in] count The number of consecutive records in the buffer to convert.
+/// @return The number of bytes converted, or -1 if an error occurred.
+/// @note The conversion is its own inverse, so the same call converts wire order to host order and
+///       host order back to wire order. If the two orders already match, the buffer is untouched.
+///       Format strings with the `^` prefix are rejected, as their keys can't be converted in place.
+ssize_t cstruct_swap_inplace(const char *format, void *buffer, size_t buffer_size, size_t count);
+
+/// Pack values as a delta against a previously packed record, keeping only the changed fields.
+/// @param[in] format The format string describing the data layout.
+/// @param[in] previous The previously packed record, which must be cstruct_sizeof(format) bytes
+///                     long, or NULL to keep every field.
+/// @param[out] buffer The buffer to pack the delta into.
+/// @param[in] buffer_size The length of the buffer.
+/// @param[in] ... The values to pack, corresponding to the format string.
+/// @return The number of bytes packed, or -1 if an error occurred.
+/// @note The delta starts with a bitmask holding one bit per field, least significant bit first,
+///       which is set if the field is present. The packed bytes of each present field follow, in
+///       order. Each numeric value and each `s` string is a field, while padding is not.
+ssize_t cstruct_pack_delta(
+    const char *format, const void *previous, void *buffer, size_t buffer_size, ...);
+
+/// Apply a delta produced by cstruct_pack_delta to the previously packed record, rebuilding the new
+/// record in place.
+/// @param[in] format The format string describing the data layout.
+/// @param[inout] record The previously packed record, which is overwritten with the new record.
+/// @param[in] record_size The length of the record.
+/// @param[in] delta The delta to apply.
+/// @param[in] delta_size The length of the delta.
+/// @return The number of bytes of the delta which were applied, or -1 if an error occurred.
+ssize_t cstruct_apply_delta(
+    const char *format, void *record, size_t record_size, const void *delta, size_t delta_size);
+
+/// Pack the members of a struct into a binary blob according to the format string.
+/// @param[in] format The format string describing the data layout.
+/// @param[out] buffer The buffer to pack the data into.
+/// @param[in] buffer_size The length of the buffer.
+/// @param[in] object The struct to pack.
+/// @param[in] offsets The offset of each value within the struct, as given by offsetof, in the
+///                    order of the format string. Each numeric value and each `s` string has one
+///                    offset, while padding has none.
+/// @param[in] offset_count The number of offsets.
+/// @return The number of bytes packed, or -1 if an error occurred.
+/// @note Each numeric value must be held in a member of exactly its packed size, e.g. int16_t or
+///       uint16_t for `h` and `H`, and float for `f`.
+ssize_t cstruct_pack_struct(
+    const char   *format,
+    void         *buffer,
+    size_t        buffer_size,
+    const void   *object,
+    const size_t *offsets,
+    size_t        offset_count);
+
+/// Unpack values from a binary blob into the members of a struct according to the format string.
+/// @param[in] format The format string describing the data layout.
+/// @param[in] buffer The buffer to unpack the data from.
+/// @param[in] buffer_size The length of the buffer.
+/// @param[out] object The struct to unpack into.
+/// @param[in] offsets The offset of each value within the struct, as for cstruct_pack_struct.
+/// @param[in] offset_count The number of offsets.
+/// @return The number of bytes unpacked, or -1 if an error occurred.
+ssize_t cstruct_unpack_struct(
+    const char   *format,
+    const void   *buffer,
+    size_t        buffer_size,
+    void         *object,
+    const size_t *offsets,
+    size_t        offset_count);
+
+/// Describe the fields of the packed blob which the format string describes, in order.
+/// @param[in] format The format string.
+/// @param[out] fields The array to store the fields in, which may be NULL if field_capacity is 0.
+/// @param[in] field_capacity The length of the array.
+/// @return The total number of fields, which may be more than field_capacity, or -1 if the format
+///         string is invalid.
+/// @note Each numeric value, each `s` string, and each run of `x` padding is one field. Groups are
+///       expanded, so every iteration of a group contributes its own fields.
+ssize_t cstruct_fields(const char *format, cstruct_field_t *fields, size_t field_capacity);
+
+/// Return true if the format string packs multi-byte values in little-endian order.
+/// @param[in] format The format string.
+/// @return True if values are packed little-endian, and false if they are packed big-endian or the
+///         format string is NULL or empty.
+/// @note `@` and `=` follow the host, while `^` keys are always big-endian.
+bool cstruct_is_little_endian(const char *format);
+
+/// Return true if a packed blob is laid out exactly like a struct in memory, so that the struct can
+/// be packed and unpacked with a single memcpy.
+/// @param[in] format The format string describing the data layout.
+/// @param[in] offsets The offset of each value within the struct, as for cstruct_pack_struct.
+/// @param[in] offset_count The number of offsets.
+/// @param[in] object_size The size of the struct, as given by sizeof.
+/// @return True if the byte order of the format string is that of the host, every value is packed
+///         at the same offset as its member, and the packed blob fits within the struct. False
+///         otherwise, or if the format string is invalid.
+/// @note Padding, whether `x` or inserted for `@` alignment, doesn't rule out an overlay. It must
+///       still be packed as zeroes after the memcpy, and skipped when unpacking, since it may lie
+///       over a member which isn't packed.
+bool cstruct_is_overlay(
+    const char *format, const size_t *offsets, size_t offset_count, size_t object_size);
+
+/// Find the first of an array of sorted packed records which is not less than a packed key. Records
+/// are compared with memcmp, so that `^` keys, and any other records which sort with memcmp, are
+/// searched without being unpacked.
+/// @param[in] format The format string describing the layout of a single record.
+/// @param[in] records The packed records, in ascending order.
+/// @param[in] count The number of records.
+/// @param[in] key The packed key, which is compared with the first key_size bytes of each record.
+/// @param[in] key_size The length of the key, which may be shorter than a record, to search by the
+///                     leading fields alone.
+/// @return The index of the first record which is not less than the key, or count if there is
+///         none, or -1 if an error occurred.
+ssize_t cstruct_key_search(
+    const char *format, const void *records, size_t count, const void *key, size_t key_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,1241 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// NOTE(Caleb):
+// - This header is a header-only C++20 binding which produces exactly the same packed blobs as
+//   cstruct.h, but parses format strings at compile time
+// - Invalid format strings, and values whose types don't match their format characters, are
+//   compile-time errors
+
+namespace cstruct
+{
+
+/// A format string, usable as a template argument.
+template <std::size_t N>
+struct format_string
+{
+    char data[N] = {};
+
+    consteval format_string(const char (&format)[N])
+    {
+        for (std::size_t i = 0; i < N; i++)
+        {
+            data[i] = format[i];
+        }
+    }
+
+    constexpr std::string_view view() const
+    {
+        return {data, N - 1};
+    }
+};
+
+namespace detail
+{
+
+// NOTE(Caleb): Maximum nesting depth of parenthesised groups, as in cstruct.c
+inline constexpr std::size_t max_group_depth = 8;
+
+/// The byte order of a packed blob.
+enum class byte_order
+{
+    big,
+    little,
+};
+
+/// A single element of a parsed format string: either one value, or one run of padding.
+struct element
+{
+    char        code;   // The format character
+    std::size_t size;   // The size of the element in bytes
+    std::size_t offset; // The offset of the element within the packed blob
+};
+
+/// Return the size of the type which the given format character represents, or 0 if the format
+/// character is not valid.
+consteval std::size_t code_size(char code)
+{
+    switch (code)
+    {
+        case 'x':
+        case 'b':
+        case 'B':
+        case 's':
+            return 1;
+
+        case 'h':
+        case 'H':
+            return 2;
+
+        case 'i':
+        case 'I':
+        case 'l':
+        case 'L':
+        case 'f':
+            return 4;
+
+        case 'q':
+        case 'Q':
+        case 'd':
+            return 8;
+
+        default:
+            return 0;
+    }
+}
+
+/// The byte order of the host.
+inline constexpr byte_order native_order =
+    std::endian::native == std::endian::little ? byte_order::little : byte_order::big;
+
+/// Return the byte order of the format string.
+consteval byte_order parse_byte_order(std::string_view format)
+{
+    if (!format.empty() && (format[0] == '@' || format[0] == '='))
+    {
+        return native_order;
+    }
+
+    return !format.empty() && format[0] == '<' ? byte_order::little : byte_order::big;
+}
+
+/// Return the index of the first format character after the byte order specifier.
+consteval std::size_t skip_byte_order(std::string_view format)
+{
+    bool prefixed = !format.empty() && std::string_view("!<>@=^").find(format[0]) != format.npos;
+    return prefixed ? 1 : 0;
+}
+
+/// Return true if the format string selects native sizes and alignment.
+consteval bool is_native(std::string_view format)
+{
+    return !format.empty() && format[0] == '@';
+}
+
+/// Return true if the format string selects the order-preserving key encoding.
+consteval bool is_key(std::string_view format)
+{
+    return !format.empty() && format[0] == '^';
+}
+
+/// Return the format character which stands in for the given one. Under native sizes, `l` and `L`
+/// become the standard format characters of the same size as a C long.
+consteval char native_code(char code, bool native)
+{
+    if (!native || (code != 'l' && code != 'L'))
+    {
+        return code;
+    }
+
+    if constexpr (sizeof(long) == 8)
+    {
+        return code == 'l' ? 'q' : 'Q';
+    }
+    else
+    {
+        return code == 'l' ? 'i' : 'I';
+    }
+}
+
+/// Return the native alignment of the type which the given format character represents.
+consteval std::size_t code_alignment(char code)
+{
+    switch (code)
+    {
+        case 'h':
+        case 'H':
+            return alignof(std::int16_t);
+
+        case 'i':
+        case 'I':
+            return alignof(std::int32_t);
+
+        case 'q':
+        case 'Q':
+            return alignof(std::int64_t);
+
+        case 'f':
+            return alignof(float);
+
+        case 'd':
+            return alignof(double);
+
+        default:
+            return 1;
+    }
+}
+
+/// Return the largest native alignment of any value in the group which starts at the given index.
+consteval std::size_t group_alignment(std::string_view format, std::size_t i, bool native)
+{
+    std::size_t alignment = 1;
+
+    for (std::size_t depth = 0; i < format.size(); i++)
+    {
+        if (format[i] == '(')
+        {
+            depth++;
+        }
+        else if (format[i] == ')')
+        {
+            if (depth-- == 0)
+            {
+                break;
+            }
+        }
+        else
+        {
+            alignment = std::max(alignment, code_alignment(native_code(format[i], native)));
+        }
+    }
+
+    return alignment;
+}
+
+/// Parse a repeat count, and advance the index past it.
+consteval std::size_t parse_multiplier(std::string_view format, std::size_t &i)
+{
+    if (i >= format.size() || format[i] < '0' || format[i] > '9')
+    {
+        return 1;
+    }
+
+    std::size_t multiplier = 0;
+    while (i < format.size() && format[i] >= '0' && format[i] <= '9')
+    {
+        std::size_t digit = format[i] - '0';
+
+        // NOTE(Caleb): As in cstruct.c, repeat counts must fit in an int64_t
+        if (multiplier > (INT64_MAX - digit) / 10)
+        {
+            throw "cstruct: repeat counts must fit in an int64_t";
+        }
+
+        multiplier = multiplier * 10 + digit;
+        i++;
+    }
+
+    if (multiplier == 0)
+    {
+        throw "cstruct: repeat counts must be greater than zero";
+    }
+
+    return multiplier;
+}
+
+/// Walk the format characters from the given index up to the end of the enclosing group, calling
+/// visit for every element. Groups are expanded, since every value is a separate argument. Under
+/// native alignment, padding elements are inserted exactly where cstruct.c inserts them.
+template <class Visitor>
+consteval void walk(
+    std::string_view format,
+    std::size_t     &i,
+    std::size_t      depth,
+    bool             native,
+    std::size_t     &offset,
+    Visitor         &visit)
+{
+    auto pad = [&](std::size_t alignment) {
+        std::size_t padding = (alignment - offset % alignment) % alignment;
+        if (padding > 0)
+        {
+            visit(element {'x', padding, offset});
+            offset += padding;
+        }
+    };
+
+    while (i < format.size() && format[i] != ')')
+    {
+        std::size_t multiplier = parse_multiplier(format, i);
+
+        if (i >= format.size())
+        {
+            throw "cstruct: a repeat count must be followed by a format character or group";
+        }
+
+        if (format[i] == '(')
+        {
+            if (depth + 1 > max_group_depth)
+            {
+                throw "cstruct: groups are nested too deeply";
+            }
+
+            if (i + 1 < format.size() && format[i + 1] == ')')
+            {
+                throw "cstruct: groups must not be empty";
+            }
+
+            // NOTE(Caleb): Under native alignment, a group is aligned like a struct, and each
+            // iteration is padded out like an element of an array of structs
+            std::size_t start     = i + 1;
+            std::size_t alignment = native ? group_alignment(format, start, native) : 1;
+
+            pad(alignment);
+            for (std::size_t j = 0; j < multiplier; j++)
+            {
+                i = start;
+                walk(format, i, depth + 1, native, offset, visit);
+                pad(alignment);
+            }
+
+            if (i >= format.size())
+            {
+                throw "cstruct: a group was never closed";
+            }
+
+            i++;
+            continue;
+        }
+
+        char        code = native_code(format[i], native);
+        std::size_t size = code_size(code);
+
+        if (size == 0)
+        {
+            throw "cstruct: invalid format character";
+        }
+
+        if (native)
+        {
+            pad(code_alignment(code));
+        }
+
+        // NOTE(Caleb): Padding and strings are single elements, while other runs are one element
+        // per value
+        if (code == 'x' || code == 's')
+        {
+            visit(element {code, multiplier, offset});
+            offset += multiplier;
+        }
+        else
+        {
+            for (std::size_t j = 0; j < multiplier; j++)
+            {
+                visit(element {code, size, offset});
+                offset += size;
+            }
+        }
+
+        i++;
+    }
+}
+
+/// Walk every element of the format string, calling visit for each one.
+template <class Visitor>
+consteval void walk(std::string_view format, Visitor &visit)
+{
+    if (format.empty())
+    {
+        throw "cstruct: format strings must not be empty";
+    }
+
+    std::size_t i      = skip_byte_order(format);
+    std::size_t offset = 0;
+
+    walk(format, i, 0, is_native(format), offset, visit);
+
+    if (i != format.size())
+    {
+        throw "cstruct: a group was closed without being opened";
+    }
+}
+
+/// Return the number of elements in the format string.
+consteval std::size_t count_elements(std::string_view format)
+{
+    std::size_t count = 0;
+    auto        visit = [&](element) { count++; };
+
+    walk(format, visit);
+    return count;
+}
+
+/// Return every element of the format string.
+template <std::size_t N>
+consteval std::array<element, N> parse_elements(std::string_view format)
+{
+    std::array<element, N> elements {};
+    std::size_t            count = 0;
+    auto                   visit = [&](element e) { elements[count++] = e; };
+
+    walk(format, visit);
+    return elements;
+}
+
+/// The compile-time layout of a format string.
+template <format_string Format>
+struct layout
+{
+    static constexpr std::string_view format        = Format.view();
+    static constexpr byte_order       order         = parse_byte_order(format);
+    static constexpr bool             key           = is_key(format);
+    static constexpr std::size_t      element_count = count_elements(format);
+
+    static constexpr std::array<element, element_count> elements =
+        parse_elements<element_count>(format);
+
+    static constexpr std::size_t size = [] {
+        std::size_t total = 0;
+        for (const element &e : elements)
+        {
+            total += e.size;
+        }
+
+        return total;
+    }();
+
+    static constexpr std::size_t value_count = [] {
+        std::size_t count = 0;
+        for (const element &e : elements)
+        {
+            count += e.code != 'x';
+        }
+
+        return count;
+    }();
+
+    // NOTE(Caleb): The index into elements of each value, skipping over padding
+    static constexpr std::array<std::size_t, value_count> values = [] {
+        std::array<std::size_t, value_count> indices {};
+        std::size_t                          count = 0;
+
+        for (std::size_t i = 0; i < element_count; i++)
+        {
+            if (elements[i].code != 'x')
+            {
+                indices[count++] = i;
+            }
+        }
+
+        return indices;
+    }();
+};
+
+/// The native type of the value represented by a numeric format character, and the unsigned type
+/// of the same width in which it is packed.
+template <char Code>
+struct code_traits;
+
+template <>
+struct code_traits<'b'>
+{
+    using value_type = std::int8_t;
+    using bits_type  = std::uint8_t;
+};
+
+template <>
+struct code_traits<'B'>
+{
+    using value_type = std::uint8_t;
+    using bits_type  = std::uint8_t;
+};
+
+template <>
+struct code_traits<'h'>
+{
+    using value_type = std::int16_t;
+    using bits_type  = std::uint16_t;
+};
+
+template <>
+struct code_traits<'H'>
+{
+    using value_type = std::uint16_t;
+    using bits_type  = std::uint16_t;
+};
+
+template <>
+struct code_traits<'i'>
+{
+    using value_type = std::int32_t;
+    using bits_type  = std::uint32_t;
+};
+
+template <>
+struct code_traits<'I'>
+{
+    using value_type = std::uint32_t;
+    using bits_type  = std::uint32_t;
+};
+
+template <>
+struct code_traits<'l'>
+{
+    using value_type = std::int32_t;
+    using bits_type  = std::uint32_t;
+};
+
+template <>
+struct code_traits<'L'>
+{
+    using value_type = std::uint32_t;
+    using bits_type  = std::uint32_t;
+};
+
+template <>
+struct code_traits<'q'>
+{
+    using value_type = std::int64_t;
+    using bits_type  = std::uint64_t;
+};
+
+template <>
+struct code_traits<'Q'>
+{
+    using value_type = std::uint64_t;
+    using bits_type  = std::uint64_t;
+};
+
+template <>
+struct code_traits<'f'>
+{
+    using value_type = float;
+    using bits_type  = std::uint32_t;
+};
+
+template <>
+struct code_traits<'d'>
+{
+    using value_type = double;
+    using bits_type  = std::uint64_t;
+};
+
+/// True if T is a character type which may hold an `s` string.
+template <class T>
+inline constexpr bool is_char_v = std::is_same_v<std::remove_cv_t<T>, char>;
+
+/// True if T is a std::array.
+template <class T>
+inline constexpr bool is_std_array_v = false;
+
+template <class T, std::size_t N>
+inline constexpr bool is_std_array_v<std::array<T, N>> = true;
+
+/// True if T is a std::array of characters.
+template <class T>
+inline constexpr bool is_char_std_array_v = false;
+
+template <class T, std::size_t N>
+inline constexpr bool is_char_std_array_v<std::array<T, N>> = is_char_v<T>;
+
+/// True if T is a std::tuple.
+template <class T>
+inline constexpr bool is_tuple_v = false;
+
+template <class... Ts>
+inline constexpr bool is_tuple_v<std::tuple<Ts...>> = true;
+
+/// True if a value of type Arg may be packed for the numeric format character Code.
+template <char Code, class Arg>
+inline constexpr bool packable_v =
+    std::is_floating_point_v<typename code_traits<Code>::value_type>
+        ? std::is_arithmetic_v<Arg>
+        : std::is_integral_v<Arg>;
+
+/// True if a value for the numeric format character Code may be unpacked into an Out.
+template <char Code, class Out>
+inline constexpr bool unpackable_v = [] {
+    using value_type = typename code_traits<Code>::value_type;
+
+    if constexpr (std::is_floating_point_v<value_type>)
+    {
+        return std::is_same_v<Out, value_type>;
+    }
+    else
+    {
+        return std::is_integral_v<Out> && sizeof(Out) == sizeof(value_type)
+            && std::is_signed_v<Out> == std::is_signed_v<value_type>;
+    }
+}();
+
+/// Reverse the byte order of an unsigned integer.
+template <class T>
+constexpr T byteswap(T x)
+{
+    if constexpr (sizeof(T) == 1)
+    {
+        return x;
+    }
+    else if constexpr (sizeof(T) == 2)
+    {
+        return static_cast<T>((x << 8) | (x >> 8));
+    }
+    else
+    {
+        T result = 0;
+        for (std::size_t i = 0; i < sizeof(T); i++)
+        {
+            result = static_cast<T>((result << 8) | ((x >> (i * 8)) & 0xFF));
+        }
+
+        return result;
+    }
+}
+
+/// Convert between native byte order and the given byte order.
+template <byte_order Order, class T>
+constexpr T convert(T x)
+{
+    constexpr bool little = Order == byte_order::little;
+
+    if constexpr (little == (std::endian::native == std::endian::little))
+    {
+        return x;
+    }
+    else
+    {
+        return byteswap(x);
+    }
+}
+
+/// Apply the order-preserving key transform to the bits of a value in native byte order, or reverse
+/// it, as cstruct.c does for `^` format strings.
+template <char Code, bool Encode, class T>
+constexpr T transform_key(T bits)
+{
+    constexpr T sign = static_cast<T>(T(1) << (sizeof(T) * 8 - 1));
+
+    if constexpr (Code == 'f' || Code == 'd')
+    {
+        // NOTE(Caleb): Negative values are flipped entirely, so that larger magnitudes sort lower
+        bool negative = Encode ? (bits & sign) != 0 : (bits & sign) == 0;
+        return negative ? static_cast<T>(~bits) : static_cast<T>(bits ^ sign);
+    }
+    else if constexpr (Code == 'b' || Code == 'h' || Code == 'i' || Code == 'l' || Code == 'q')
+    {
+        return static_cast<T>(bits ^ sign);
+    }
+    else
+    {
+        return bits;
+    }
+}
+
+/// Pack an `s` string of Size bytes.
+template <std::size_t Size, class Arg>
+inline void pack_string(std::byte *dest, const Arg &value)
+{
+    std::memset(dest, 0, Size);
+
+    if constexpr (std::is_array_v<Arg> && is_char_v<std::remove_extent_t<Arg>>)
+    {
+        std::memcpy(dest, value, std::min(Size, std::extent_v<Arg>));
+    }
+    else if constexpr (is_char_std_array_v<Arg>)
+    {
+        std::memcpy(dest, value.data(), std::min(Size, value.size()));
+    }
+    else if constexpr (std::is_convertible_v<const Arg &, std::string_view>)
+    {
+        std::string_view view = value;
+        std::memcpy(dest, view.data(), std::min(Size, view.size()));
+    }
+    else
+    {
+        static_assert(
+            std::is_convertible_v<const Arg &, std::string_view>,
+            "cstruct: values for 's' must be character arrays or convertible to std::string_view");
+    }
+}
+
+/// Unpack an `s` string of Size bytes.
+template <std::size_t Size, class Out>
+inline void unpack_string(const std::byte *src, Out &out)
+{
+    if constexpr (std::is_array_v<Out> && is_char_v<std::remove_extent_t<Out>>)
+    {
+        static_assert(std::extent_v<Out> >= Size, "cstruct: array is too small for its 's' string");
+        std::memcpy(out, src, Size);
+    }
+    else if constexpr (is_char_std_array_v<Out>)
+    {
+        static_assert(
+            std::tuple_size_v<Out> >= Size, "cstruct: array is too small for its 's' string");
+        std::memcpy(out.data(), src, Size);
+    }
+    else
+    {
+        static_assert(is_std_array_v<Out>, "cstruct: 's' strings must be unpacked to char arrays");
+    }
+}
+
+/// Pack the value for the element with the given index.
+template <class Layout, std::size_t Index, class Arg>
+inline void pack_value(std::byte *blob, const Arg &value)
+{
+    constexpr element e    = Layout::elements[Index];
+    std::byte        *dest = blob + e.offset;
+
+    if constexpr (e.code == 's')
+    {
+        pack_string<e.size>(dest, value);
+    }
+    else
+    {
+        using traits = code_traits<e.code>;
+
+        static_assert(packable_v<e.code, Arg>, "cstruct: value type does not match the format");
+
+        auto bits = std::bit_cast<typename traits::bits_type>(
+            static_cast<typename traits::value_type>(value));
+
+        if constexpr (Layout::key)
+        {
+            bits = transform_key<e.code, true>(bits);
+        }
+
+        bits = convert<Layout::order>(bits);
+
+        std::memcpy(dest, &bits, sizeof(bits));
+    }
+}
+
+/// Unpack the value for the element with the given index.
+template <class Layout, std::size_t Index, class Out>
+inline void unpack_value(const std::byte *blob, Out &out)
+{
+    constexpr element e   = Layout::elements[Index];
+    const std::byte  *src = blob + e.offset;
+
+    if constexpr (e.code == 's')
+    {
+        unpack_string<e.size>(src, out);
+    }
+    else
+    {
+        using traits = code_traits<e.code>;
+
+        static_assert(unpackable_v<e.code, Out>, "cstruct: output type does not match the format");
+
+        typename traits::bits_type bits;
+        std::memcpy(&bits, src, sizeof(bits));
+
+        bits = convert<Layout::order>(bits);
+
+        if constexpr (Layout::key)
+        {
+            bits = transform_key<e.code, false>(bits);
+        }
+
+        out = static_cast<Out>(std::bit_cast<typename traits::value_type>(bits));
+    }
+}
+
+/// The type of the I-th value of a layout, as returned by unpack.
+template <class Layout, std::size_t I>
+struct value_type_of
+{
+    static constexpr element e = Layout::elements[Layout::values[I]];
+
+    using type = std::conditional_t<
+        e.code == 's',
+        std::array<char, e.size>,
+        typename code_traits<e.code == 's' ? 'B' : e.code>::value_type>;
+};
+
+/// The tuple of every value of a layout, as returned by unpack.
+template <class Layout, class Indices = std::make_index_sequence<Layout::value_count>>
+struct tuple_of;
+
+template <class Layout, std::size_t... I>
+struct tuple_of<Layout, std::index_sequence<I...>>
+{
+    using type = std::tuple<typename value_type_of<Layout, I>::type...>;
+};
+
+/// A value which converts to anything, used to count the members of an aggregate.
+struct any_initializer
+{
+    template <class T>
+    constexpr operator T() const noexcept;
+};
+
+/// True if T can be initialized from N braced initializers. Each initializer is braced, so that an
+/// array member is counted once rather than once per element.
+template <class T, std::size_t... I>
+consteval bool initializable(std::index_sequence<I...>)
+{
+    return requires { T {{((void)I, any_initializer {})}...}; };
+}
+
+/// Return the number of members of an aggregate.
+template <class T, std::size_t N = 0>
+consteval std::size_t member_count()
+{
+    if constexpr (initializable<T>(std::make_index_sequence<N + 1> {}))
+    {
+        return member_count<T, N + 1>();
+    }
+    else
+    {
+        return N;
+    }
+}
+
+/// Return a tuple of references to every member of an aggregate.
+template <class T>
+constexpr auto tie_members(T &object)
+{
+    constexpr std::size_t N = member_count<std::remove_cv_t<T>>();
+    static_assert(N > 0 && N <= 24, "cstruct: aggregates must have between 1 and 24 members");
+
+    // clang-format off
+    if constexpr (N == 1)
+    {
+        auto &[m0] = object;
+        return std::tie(m0);
+    }
+    else if constexpr (N == 2)
+    {
+        auto &[m0, m1] = object;
+        return std::tie(m0, m1);
+    }
+    else if constexpr (N == 3)
+    {
+        auto &[m0, m1, m2] = object;
+        return std::tie(m0, m1, m2);
+    }
+    else if constexpr (N == 4)
+    {
+        auto &[m0, m1, m2, m3] = object;
+        return std::tie(m0, m1, m2, m3);
+    }
+    else if constexpr (N == 5)
+    {
+        auto &[m0, m1, m2, m3, m4] = object;
+        return std::tie(m0, m1, m2, m3, m4);
+    }
+    else if constexpr (N == 6)
+    {
+        auto &[m0, m1, m2, m3, m4, m5] = object;
+        return std::tie(m0, m1, m2, m3, m4, m5);
+    }
+    else if constexpr (N == 7)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6] = object;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6);
+    }
+    else if constexpr (N == 8)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7] = object;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7);
+    }
+    else if constexpr (N == 9)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8] = object;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8);
+    }
+    else if constexpr (N == 10)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9] = object;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9);
+    }
+    else if constexpr (N == 11)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10] = object;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10);
+    }
+    else if constexpr (N == 12)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11] = object;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11);
+    }
+    else if constexpr (N == 13)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12] = object;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12);
+    }
+    else if constexpr (N == 14)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13] = object;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13);
+    }
+    else if constexpr (N == 15)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14] = object;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14);
+    }
+    else if constexpr (N == 16)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15] = object;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15);
+    }
+    else if constexpr (N == 17)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16] = object;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16);
+    }
+    else if constexpr (N == 18)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17] =
+            object;
+        return std::tie(
+            m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17);
+    }
+    else if constexpr (N == 19)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17,
+               m18] = object;
+        return std::tie(
+            m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18);
+    }
+    else if constexpr (N == 20)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17,
+               m18, m19] = object;
+        return std::tie(
+            m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18,
+            m19);
+    }
+    else if constexpr (N == 21)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17,
+               m18, m19, m20] = object;
+        return std::tie(
+            m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18,
+            m19, m20);
+    }
+    else if constexpr (N == 22)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17,
+               m18, m19, m20, m21] = object;
+        return std::tie(
+            m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18,
+            m19, m20, m21);
+    }
+    else if constexpr (N == 23)
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17,
+               m18, m19, m20, m21, m22] = object;
+        return std::tie(
+            m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18,
+            m19, m20, m21, m22);
+    }
+    else
+    {
+        auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17,
+               m18, m19, m20, m21, m22, m23] = object;
+        return std::tie(
+            m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18,
+            m19, m20, m21, m22, m23);
+    }
+    // clang-format on
+}
+
+/// Return a tuple of references to every value held by a member. Arrays are flattened into one
+/// value per element, except for char arrays, which hold a single `s` string.
+template <class M>
+constexpr auto flatten_member(M &member)
+{
+    using T = std::remove_cv_t<M>;
+
+    if constexpr (std::is_array_v<T> && !is_char_v<std::remove_extent_t<T>>)
+    {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return std::tuple_cat(flatten_member(member[I])...);
+        }(std::make_index_sequence<std::extent_v<T>> {});
+    }
+    else if constexpr (is_std_array_v<T> && !is_char_std_array_v<T>)
+    {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return std::tuple_cat(flatten_member(member[I])...);
+        }(std::make_index_sequence<std::tuple_size_v<T>> {});
+    }
+    else
+    {
+        return std::tie(member);
+    }
+}
+
+/// Return a tuple of references to every value held by an aggregate or tuple.
+template <class T>
+constexpr auto flatten(T &object)
+{
+    if constexpr (is_tuple_v<std::remove_cv_t<T>>)
+    {
+        return std::apply(
+            [](auto &...members) { return std::tuple_cat(flatten_member(members)...); }, object);
+    }
+    else
+    {
+        return std::apply(
+            [](auto &...members) { return std::tuple_cat(flatten_member(members)...); },
+            tie_members(object));
+    }
+}
+
+/// True if a member of type M holds the value for the given element exactly as it is packed in
+/// native byte order.
+template <element E, class M>
+inline constexpr bool overlays_v = [] {
+    using T = std::remove_cv_t<M>;
+
+    if constexpr (E.code == 'x')
+    {
+        return false;
+    }
+    else if constexpr (E.code == 's')
+    {
+        return sizeof(T) == E.size && (std::is_array_v<T> || is_char_std_array_v<T>);
+    }
+    else
+    {
+        return unpackable_v<E.code, T>;
+    }
+}();
+
+/// True if an object of type T, whose values are referenced by a tuple of type Values, may be laid
+/// out exactly like its packed blob: the byte order is native, and every value has its packed type.
+template <class Layout, class T, class Values>
+inline constexpr bool may_overlay_v = [] {
+    if constexpr (
+        Layout::order != native_order || Layout::key || !std::is_trivially_copyable_v<T>
+        || is_tuple_v<T> || sizeof(T) < Layout::size
+        || std::tuple_size_v<Values> != Layout::value_count)
+    {
+        return false;
+    }
+    else
+    {
+        return []<std::size_t... I>(std::index_sequence<I...>) {
+            return (
+                overlays_v<
+                    Layout::elements[Layout::values[I]],
+                    std::remove_reference_t<std::tuple_element_t<I, Values>>>
+                && ...);
+        }(std::make_index_sequence<Layout::value_count> {});
+    }
+}();
+
+/// Return true if every value of an object is held at the offset at which it is packed, so that
+/// the object can be packed and unpacked with a single memcpy.
+/// @note Every member of the object is a value, so padding can only ever cover the padding of the
+///       object itself.
+template <class Layout, class T, class Values>
+inline bool is_overlay(const T &object, const Values &values)
+{
+    // NOTE(Caleb): The offsets are constants, so this folds away entirely
+    const auto *base = reinterpret_cast<const std::byte *>(&object);
+
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+        return (
+            (reinterpret_cast<const std::byte *>(&std::get<I>(values)) - base
+             == static_cast<std::ptrdiff_t>(Layout::elements[Layout::values[I]].offset))
+            && ...);
+    }(std::make_index_sequence<Layout::value_count> {});
+}
+
+/// Pack every value, and zero every run of padding.
+template <class Layout, std::size_t... I, class... Args>
+inline void pack_all(std::byte *blob, std::index_sequence<I...>, const Args &...values)
+{
+    for (const element &e : Layout::elements)
+    {
+        if (e.code == 'x')
+        {
+            std::memset(blob + e.offset, 0, e.size);
+        }
+    }
+
+    (pack_value<Layout, Layout::values[I]>(blob, values), ...);
+}
+
+/// Unpack every value.
+template <class Layout, std::size_t... I, class... Outs>
+inline void unpack_all(const std::byte *blob, std::index_sequence<I...>, Outs &...outs)
+{
+    (unpack_value<Layout, Layout::values[I]>(blob, outs), ...);
+}
+
+} // namespace detail
+
+/// The size of the packed blob described by the format string.
+template <format_string Format>
+inline constexpr std::size_t size_of = detail::layout<Format>::size;
+
+/// Pack values into a binary blob according to the format string.
+/// @param[out] buffer The buffer to pack the data into.
+/// @param[in] values The values to pack, corresponding to the format string.
+/// @return The number of bytes packed, or -1 if the buffer is too small.
+template <format_string Format, class... Args>
+inline std::ptrdiff_t pack(std::span<std::byte> buffer, const Args &...values)
+{
+    using layout = detail::layout<Format>;
+
+    static_assert(
+        sizeof...(Args) == layout::value_count,
+        "cstruct: the number of values does not match the format string");
+
+    if (buffer.size() < layout::size)
+    {
+        return -1;
+    }
+
+    detail::pack_all<layout>(buffer.data(), std::index_sequence_for<Args...> {}, values...);
+    return layout::size;
+}
+
+/// @copydoc pack
+template <format_string Format, class... Args>
+inline std::ptrdiff_t pack(std::span<std::uint8_t> buffer, const Args &...values)
+{
+    return pack<Format>(std::as_writable_bytes(buffer), values...);
+}
+
+/// Unpack values from a binary blob according to the format string.
+/// @param[in] buffer The buffer to unpack the data from.
+/// @param[out] outs Variables where the unpacked values will be stored.
+/// @return The number of bytes unpacked, or -1 if the buffer is too small.
+template <format_string Format, class... Outs>
+    requires(sizeof...(Outs) > 0)
+inline std::ptrdiff_t unpack(std::span<const std::byte> buffer, Outs &...outs)
+{
+    using layout = detail::layout<Format>;
+
+    static_assert(
+        sizeof...(Outs) == layout::value_count,
+        "cstruct: the number of outputs does not match the format string");
+
+    if (buffer.size() < layout::size)
+    {
+        return -1;
+    }
+
+    detail::unpack_all<layout>(buffer.data(), std::index_sequence_for<Outs...> {}, outs...);
+    return layout::size;
+}
+
+/// @copydoc unpack
+template <format_string Format, class... Outs>
+    requires(sizeof...(Outs) > 0)
+inline std::ptrdiff_t unpack(std::span<const std::uint8_t> buffer, Outs &...outs)
+{
+    return unpack<Format>(std::as_bytes(buffer), outs...);
+}
+
+/// Unpack values from a binary blob according to the format string.
+/// @param[in] buffer The buffer to unpack the data from.
+/// @return A tuple of the unpacked values, in which `s` strings are std::arrays of char, or
+///         std::nullopt if the buffer is too small.
+template <format_string Format>
+inline auto unpack(std::span<const std::byte> buffer)
+    -> std::optional<typename detail::tuple_of<detail::layout<Format>>::type>
+{
+    typename detail::tuple_of<detail::layout<Format>>::type values;
+
+    std::ptrdiff_t size =
+        std::apply([&](auto &...outs) { return unpack<Format>(buffer, outs...); }, values);
+    if (size < 0)
+    {
+        return std::nullopt;
+    }
+
+    return values;
+}
+
+/// @copydoc unpack(std::span<const std::byte>)
+template <format_string Format>
+inline auto unpack(std::span<const std::uint8_t> buffer)
+{
+    return unpack<Format>(std::as_bytes(buffer));
+}
+
+/// Pack the members of an aggregate struct, or the elements of a std::tuple, according to the
+/// format string.
+/// @param[out] buffer The buffer to pack the data into.
+/// @param[in] object The struct or tuple. Arrays are packed as one value per element, except for
+///                   char arrays, which are packed as a single `s` string.
+/// @return The number of bytes packed, or -1 if the buffer is too small.
+/// @note If the format string is in native byte order, and every member is packed at its own
+///       offset with its own type, the struct is packed with a single memcpy. Its padding is still
+///       packed as zeroes, exactly as by cstruct_pack.
+template <format_string Format, class T>
+inline std::ptrdiff_t pack_struct(std::span<std::byte> buffer, const T &object)
+{
+    using layout = detail::layout<Format>;
+
+    auto values = detail::flatten(object);
+
+    if constexpr (detail::may_overlay_v<layout, T, decltype(values)>)
+    {
+        if (detail::is_overlay<layout>(object, values))
+        {
+            if (buffer.size() < layout::size)
+            {
+                return -1;
+            }
+
+            std::memcpy(buffer.data(), &object, layout::size);
+
+            // NOTE(Caleb): Padding holds whatever the struct does, so it is cleared afterwards
+            for (const detail::element &e : layout::elements)
+            {
+                if (e.code == 'x')
+                {
+                    std::memset(buffer.data() + e.offset, 0, e.size);
+                }
+            }
+
+            return layout::size;
+        }
+    }
+
+    return std::apply([&](const auto &...v) { return pack<Format>(buffer, v...); }, values);
+}
+
+/// @copydoc pack_struct
+template <format_string Format, class T>
+inline std::ptrdiff_t pack_struct(std::span<std::uint8_t> buffer, const T &object)
+{
+    return pack_struct<Format>(std::as_writable_bytes(buffer), object);
+}
+
+/// Unpack into the members of an aggregate struct, or the elements of a std::tuple, according to
+/// the format string.
+/// @param[in] buffer The buffer to unpack the data from.
+/// @param[out] object The struct or tuple, laid out as for pack_struct.
+/// @return The number of bytes unpacked, or -1 if the buffer is too small.
+template <format_string Format, class T>
+inline std::ptrdiff_t unpack_struct(std::span<const std::byte> buffer, T &object)
+{
+    using layout = detail::layout<Format>;
+
+    auto outs = detail::flatten(object);
+
+    if constexpr (detail::may_overlay_v<layout, T, decltype(outs)>)
+    {
+        if (detail::is_overlay<layout>(object, outs))
+        {
+            if (buffer.size() < layout::size)
+            {
+                return -1;
+            }
+
+            std::memcpy(&object, buffer.data(), layout::size);
+            return layout::size;
+        }
+    }
+
+    return std::apply([&](auto &...o) { return unpack<Format>(buffer, o...); }, outs);
+}
+
+/// @copydoc unpack_struct
+template <format_string Format, class T>
+inline std::ptrdiff_t unpack_struct(std::span<const std::uint8_t> buffer, T &object)
+{
+    return unpack_struct<Format>(std::as_bytes(buffer), object);
+}
+
+} // namespace cstruct
@@ -0,0 +1,503 @@
+#include "cstruct_dispatch.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cstruct.h"
+#include "cstruct_jit.h"
+
+// NOTE(Caleb): Message types which span no more than this many values (or four per type, if that's
+// more) are looked up in a dense table indexed by type; sparser types get a perfect hash
+#define __CSTRUCT_DISPATCH_DENSE_SPAN 256
+
+// NOTE(Caleb): Limits on the search for a perfect hash; 2^20 slots is 4 MiB of table, which is only
+// reached with many hundreds of sparse message types
+#define __CSTRUCT_DISPATCH_MAX_HASH_BITS 20
+#define __CSTRUCT_DISPATCH_HASH_ATTEMPTS 32
+
+/// A registered message type.
+typedef struct
+{
+    uint64_t                   type;
+    cstruct_jit_t             *jit;          // The header and body, compiled together
+    size_t                     storage_size; // The storage needed to decode the message
+    cstruct_dispatch_handler_f handler;
+    void                      *context;
+} __cstruct_dispatch_entry_t;
+
+struct cstruct_dispatch
+{
+    char   *header_format;
+    size_t *header_offsets;
+    size_t  header_offset_count;
+    size_t  body_offset;  // The offset of the body within the storage for a decoded message
+    size_t  storage_size; // The storage needed to decode any registered message
+
+    size_t discriminator_offset; // The offset of the discriminator within the packed header
+    size_t discriminator_width;
+    bool   discriminator_signed;
+    bool   little_endian;
+    bool   key; // True if the discriminator is a `^` key, with its sign bit flipped
+
+    __cstruct_dispatch_entry_t *entries;
+    size_t                      entry_count;
+    size_t                      entry_capacity;
+
+    // NOTE(Caleb): Each slot of the table holds the index of an entry plus one, or zero if empty.
+    // A dense table is indexed by type - base; a hashed one by (type * seed) >> shift.
+    uint32_t *table;
+    size_t    table_size;
+    bool      dense;
+    uint64_t  base;
+    uint64_t  seed;
+    unsigned  shift;
+};
+
+/// Read the message type from a packed header.
+/// @param[in] dispatch The registry.
+/// @param[in] packed The packed header, which holds at least the discriminator.
+/// @return The message type.
+static inline uint64_t __cstruct_dispatch_read_type(
+    const cstruct_dispatch_t *dispatch, const uint8_t *packed);
+
+/// Find the slot of the lookup table which a message type would occupy.
+/// @param[in] dispatch The registry.
+/// @param[in] type The message type.
+/// @return The slot, which may be past the end of a dense table.
+static inline size_t __cstruct_dispatch_slot(const cstruct_dispatch_t *dispatch, uint64_t type);
+
+/// Rebuild the lookup table of a registry from its entries.
+/// @param[inout] dispatch The registry.
+/// @return 0 on success, or -1 if no perfect hash was found or memory ran out.
+static int __cstruct_dispatch_rebuild(cstruct_dispatch_t *dispatch);
+
+/// Try to place every entry of a registry into a hashed table without collisions.
+/// @param[in] dispatch The registry, whose seed and shift are used for the hash.
+/// @param[out] table The table, which is cleared first.
+/// @param[in] table_size The number of slots in the table.
+/// @return True if every entry has a slot to itself, and false otherwise.
+static bool __cstruct_dispatch_place(
+    const cstruct_dispatch_t *dispatch, uint32_t *table, size_t table_size);
+
+/// Return the next value of a SplitMix64 sequence.
+/// @param[inout] state The state of the sequence.
+/// @return The next value.
+static uint64_t __cstruct_dispatch_next_seed(uint64_t *state);
+
+// Public API --------------------------------------------------------------------------------------
+
+cstruct_dispatch_t *cstruct_dispatch_create(
+    const char   *header_format,
+    const size_t *header_offsets,
+    size_t        header_offset_count,
+    size_t        header_size,
+    size_t        discriminator)
+{
+    // NOTE(Caleb): cstruct_fields validates the whole format string
+    ssize_t field_count = cstruct_fields(header_format, NULL, 0);
+    if (field_count < 0 || (!header_offsets && header_offset_count > 0))
+    {
+        return NULL;
+    }
+
+    cstruct_field_t *fields = malloc(((size_t)field_count + 1) * sizeof(*fields));
+    if (!fields)
+    {
+        return NULL;
+    }
+
+    cstruct_fields(header_format, fields, (size_t)field_count);
+
+    // NOTE(Caleb): Every value of the header needs exactly one offset, as it will when compiled
+    size_t value_count = 0;
+    for (ssize_t i = 0; i < field_count; i++)
+    {
+        value_count += fields[i].format_char != 'x';
+    }
+
+    if (value_count != header_offset_count)
+    {
+        free(fields);
+        return NULL;
+    }
+
+    // NOTE(Caleb): Find the field which holds the discriminator, skipping padding
+    cstruct_field_t *field = NULL;
+    for (ssize_t i = 0, value = 0; i < field_count; i++)
+    {
+        if (fields[i].format_char != 'x' && (size_t)value++ == discriminator)
+        {
+            field = &fields[i];
+            break;
+        }
+    }
+
+    if (!field || !strchr("bBhHiIlLqQ", field->format_char))
+    {
+        free(fields);
+        return NULL;
+    }
+
+    cstruct_dispatch_t *dispatch = calloc(1, sizeof(*dispatch));
+    if (!dispatch)
+    {
+        free(fields);
+        return NULL;
+    }
+
+    dispatch->discriminator_offset = field->offset;
+    dispatch->discriminator_width  = field->size;
+    dispatch->discriminator_signed = field->format_char >= 'a';
+    dispatch->key                  = header_format[0] == '^';
+    dispatch->little_endian        = cstruct_is_little_endian(header_format);
+
+    free(fields);
+
+    size_t format_length  = strlen(header_format);
+    size_t alignment      = _Alignof(max_align_t);
+    dispatch->body_offset = (header_size + alignment - 1) / alignment * alignment;
+    dispatch->storage_size        = dispatch->body_offset;
+    dispatch->header_offset_count = header_offset_count;
+    dispatch->header_format       = malloc(format_length + 1);
+    dispatch->header_offsets      = malloc((header_offset_count + 1) * sizeof(*header_offsets));
+
+    if (!dispatch->header_format || !dispatch->header_offsets)
+    {
+        cstruct_dispatch_free(dispatch);
+        return NULL;
+    }
+
+    memcpy(dispatch->header_format, header_format, format_length + 1);
+    if (header_offset_count > 0)
+    {
+        memcpy(
+            dispatch->header_offsets, header_offsets,
+            header_offset_count * sizeof(*header_offsets));
+    }
+
+    return dispatch;
+}
+
+int cstruct_dispatch_register(
+    cstruct_dispatch_t        *dispatch,
+    uint64_t                   type,
+    const char                *body_format,
+    const size_t              *body_offsets,
+    size_t                     body_offset_count,
+    size_t                     body_size,
+    cstruct_dispatch_handler_f handler,
+    void                      *context)
+{
+    if (!dispatch || !handler || (!body_offsets && body_offset_count > 0))
+    {
+        return -1;
+    }
+
+    body_format = body_format ? body_format : "";
+
+    // NOTE(Caleb): The body takes the byte order of the header
+    if (body_format[0] != '\0' && strchr("!<>@=^", body_format[0]))
+    {
+        return -1;
+    }
+
+    size_t slot = dispatch->table ? __cstruct_dispatch_slot(dispatch, type) : 0;
+    if (slot < dispatch->table_size && dispatch->table[slot] &&
+        dispatch->entries[dispatch->table[slot] - 1].type == type)
+    {
+        return -1;
+    }
+
+    if (dispatch->entry_count == dispatch->entry_capacity)
+    {
+        size_t capacity = dispatch->entry_capacity ? dispatch->entry_capacity * 2 : 8;
+        __cstruct_dispatch_entry_t *entries =
+            realloc(dispatch->entries, capacity * sizeof(*entries));
+        if (!entries)
+        {
+            return -1;
+        }
+
+        dispatch->entries        = entries;
+        dispatch->entry_capacity = capacity;
+    }
+
+    // NOTE(Caleb): The header and body are compiled as one format string, with the body offsets
+    // moved past the header, so that a message is decoded in a single pass
+    size_t  header_length = strlen(dispatch->header_format);
+    size_t  body_length   = strlen(body_format);
+    size_t  offset_count  = dispatch->header_offset_count + body_offset_count;
+    char   *format        = malloc(header_length + body_length + 1);
+    size_t *offsets       = malloc((offset_count + 1) * sizeof(*offsets));
+
+    if (!format || !offsets)
+    {
+        free(format);
+        free(offsets);
+
+        return -1;
+    }
+
+    memcpy(format, dispatch->header_format, header_length);
+    memcpy(format + header_length, body_format, body_length + 1);
+
+    for (size_t i = 0; i < dispatch->header_offset_count; i++)
+    {
+        offsets[i] = dispatch->header_offsets[i];
+    }
+
+    for (size_t i = 0; i < body_offset_count; i++)
+    {
+        offsets[dispatch->header_offset_count + i] = dispatch->body_offset + body_offsets[i];
+    }
+
+    cstruct_jit_t *jit = cstruct_jit_compile(format, offsets, offset_count);
+
+    free(format);
+    free(offsets);
+
+    if (!jit)
+    {
+        return -1;
+    }
+
+    __cstruct_dispatch_entry_t *entry = &dispatch->entries[dispatch->entry_count++];
+
+    entry->type         = type;
+    entry->jit          = jit;
+    entry->storage_size = dispatch->body_offset + body_size;
+    entry->handler      = handler;
+    entry->context      = context;
+
+    if (__cstruct_dispatch_rebuild(dispatch) < 0)
+    {
+        cstruct_jit_free(jit);
+        dispatch->entry_count--;
+
+        // NOTE(Caleb): The table without the new type was built before, so it can be built again
+        __cstruct_dispatch_rebuild(dispatch);
+        return -1;
+    }
+
+    if (entry->storage_size > dispatch->storage_size)
+    {
+        dispatch->storage_size = entry->storage_size;
+    }
+
+    return 0;
+}
+
+size_t cstruct_dispatch_storage_size(const cstruct_dispatch_t *dispatch)
+{
+    return dispatch ? dispatch->storage_size : 0;
+}
+
+ssize_t cstruct_dispatch(
+    const cstruct_dispatch_t *dispatch,
+    const void               *buffer,
+    size_t                    buffer_size,
+    void                     *storage,
+    size_t                    storage_size)
+{
+    if (!dispatch || !buffer || !storage || dispatch->entry_count == 0)
+    {
+        return -1;
+    }
+
+    if (buffer_size < dispatch->discriminator_offset + dispatch->discriminator_width)
+    {
+        return -1;
+    }
+
+    uint64_t type = __cstruct_dispatch_read_type(dispatch, buffer);
+    size_t   slot = __cstruct_dispatch_slot(dispatch, type);
+    if (slot >= dispatch->table_size || !dispatch->table[slot])
+    {
+        return -1;
+    }
+
+    const __cstruct_dispatch_entry_t *entry = &dispatch->entries[dispatch->table[slot] - 1];
+    if (entry->type != type || storage_size < entry->storage_size)
+    {
+        return -1;
+    }
+
+    ssize_t size = cstruct_jit_unpack(entry->jit, buffer, buffer_size, storage);
+    if (size < 0)
+    {
+        return -1;
+    }
+
+    entry->handler(storage, (uint8_t *)storage + dispatch->body_offset, entry->context);
+    return size;
+}
+
+void cstruct_dispatch_free(cstruct_dispatch_t *dispatch)
+{
+    if (!dispatch)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < dispatch->entry_count; i++)
+    {
+        cstruct_jit_free(dispatch->entries[i].jit);
+    }
+
+    free(dispatch->header_format);
+    free(dispatch->header_offsets);
+    free(dispatch->entries);
+    free(dispatch->table);
+    free(dispatch);
+}
+
+// Private Helpers ---------------------------------------------------------------------------------
+
+static inline uint64_t __cstruct_dispatch_read_type(
+    const cstruct_dispatch_t *dispatch, const uint8_t *packed)
+{
+    size_t   width = dispatch->discriminator_width;
+    uint64_t type  = 0;
+
+    packed += dispatch->discriminator_offset;
+    for (size_t i = 0; i < width; i++)
+    {
+        type = (type << 8) | packed[dispatch->little_endian ? width - 1 - i : i];
+    }
+
+    if (dispatch->discriminator_signed && dispatch->key)
+    {
+        type ^= 1ULL << (width * 8 - 1);
+    }
+
+    if (dispatch->discriminator_signed && width < 8)
+    {
+        uint64_t sign = 1ULL << (width * 8 - 1);
+        type          = (type ^ sign) - sign;
+    }
+
+    return type;
+}
+
+static inline size_t __cstruct_dispatch_slot(const cstruct_dispatch_t *dispatch, uint64_t type)
+{
+    if (dispatch->dense)
+    {
+        // NOTE(Caleb): Types below the base wrap around to huge slots, which are out of range
+        uint64_t slot = type - dispatch->base;
+        return slot < dispatch->table_size ? (size_t)slot : dispatch->table_size;
+    }
+
+    return (size_t)((type * dispatch->seed) >> dispatch->shift);
+}
+
+static int __cstruct_dispatch_rebuild(cstruct_dispatch_t *dispatch)
+{
+    size_t   count = dispatch->entry_count;
+    uint64_t min   = UINT64_MAX;
+    uint64_t max   = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        min = dispatch->entries[i].type < min ? dispatch->entries[i].type : min;
+        max = dispatch->entries[i].type > max ? dispatch->entries[i].type : max;
+    }
+
+    free(dispatch->table);
+    dispatch->table      = NULL;
+    dispatch->table_size = 0;
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t span = __CSTRUCT_DISPATCH_DENSE_SPAN > 4 * count ? __CSTRUCT_DISPATCH_DENSE_SPAN
+                                                               : 4 * count;
+    if (max - min < span)
+    {
+        dispatch->dense      = true;
+        dispatch->base       = min;
+        dispatch->table_size = (size_t)(max - min) + 1;
+        dispatch->table      = calloc(dispatch->table_size, sizeof(*dispatch->table));
+        if (!dispatch->table)
+        {
+            dispatch->table_size = 0;
+            return -1;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            dispatch->table[dispatch->entries[i].type - min] = (uint32_t)i + 1;
+        }
+
+        return 0;
+    }
+
+    // NOTE(Caleb): Search for a multiplier which sends every type to a slot of its own, growing the
+    // table whenever too many multipliers collide
+    unsigned bits = 1;
+    while (((size_t)1 << bits) < 2 * count)
+    {
+        bits++;
+    }
+
+    uint64_t state = 0;
+    for (; bits <= __CSTRUCT_DISPATCH_MAX_HASH_BITS; bits++)
+    {
+        size_t    table_size = (size_t)1 << bits;
+        uint32_t *table      = malloc(table_size * sizeof(*table));
+        if (!table)
+        {
+            return -1;
+        }
+
+        dispatch->dense = false;
+        dispatch->shift = 64 - bits;
+
+        for (int attempt = 0; attempt < __CSTRUCT_DISPATCH_HASH_ATTEMPTS; attempt++)
+        {
+            dispatch->seed = __cstruct_dispatch_next_seed(&state) | 1;
+            if (__cstruct_dispatch_place(dispatch, table, table_size))
+            {
+                dispatch->table      = table;
+                dispatch->table_size = table_size;
+
+                return 0;
+            }
+        }
+
+        free(table);
+    }
+
+    return -1;
+}
+
+static bool __cstruct_dispatch_place(
+    const cstruct_dispatch_t *dispatch, uint32_t *table, size_t table_size)
+{
+    memset(table, 0, table_size * sizeof(*table));
+
+    for (size_t i = 0; i < dispatch->entry_count; i++)
+    {
+        size_t slot = __cstruct_dispatch_slot(dispatch, dispatch->entries[i].type);
+        if (table[slot])
+        {
+            return false;
+        }
+
+        table[slot] = (uint32_t)i + 1;
+    }
+
+    return true;
+}
+
+static uint64_t __cstruct_dispatch_next_seed(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z          = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
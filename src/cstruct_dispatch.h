@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/// A registry which decodes messages of many types that share a header, and passes each one to the
+/// handler for its type.
+/// @note The type of a message is read from a discriminator field of its header, and looked up in a
+///       dense table or a perfect hash, so dispatch costs the same however many types there are.
+///       The header and body of each type are compiled together (see cstruct_jit.h), so a message
+///       is decoded in a single pass.
+typedef struct cstruct_dispatch cstruct_dispatch_t;
+
+/// A handler for a single message type.
+/// @param[in] header The decoded header.
+/// @param[in] body The decoded body.
+/// @param[in] context The context given when the handler was registered.
+typedef void (*cstruct_dispatch_handler_f)(const void *header, const void *body, void *context);
+
+/// Create a registry for messages with the given header.
+/// @param[in] header_format The format string describing the header, which also sets the byte
+///                          order of every body.
+/// @param[in] header_offsets The offset of each value of the header within the header struct, as
+///                           for cstruct_pack_struct.
+/// @param[in] header_offset_count The number of header offsets.
+/// @param[in] header_size The size of the header struct.
+/// @param[in] discriminator The index of the value of the header which holds the message type,
+///                          which must be an integer.
+/// @return The registry, or NULL if an error occurred.
+cstruct_dispatch_t *cstruct_dispatch_create(
+    const char   *header_format,
+    const size_t *header_offsets,
+    size_t        header_offset_count,
+    size_t        header_size,
+    size_t        discriminator);
+
+/// Register the body layout and handler for a message type.
+/// @param[inout] dispatch The registry.
+/// @param[in] type The value of the discriminator for this message type. Signed discriminators are
+///                 sign extended, so e.g. (uint64_t)-1 matches a `b` discriminator of -1.
+/// @param[in] body_format The format string describing the body, without a byte order specifier,
+///                        or NULL if the message has no body.
+/// @param[in] body_offsets The offset of each value of the body within the body struct.
+/// @param[in] body_offset_count The number of body offsets.
+/// @param[in] body_size The size of the body struct.
+/// @param[in] handler The handler for this message type.
+/// @param[in] context A pointer which is passed to the handler as is.
+/// @return 0 on success, or -1 if the type is already registered or an error occurred.
+int cstruct_dispatch_register(
+    cstruct_dispatch_t        *dispatch,
+    uint64_t                   type,
+    const char                *body_format,
+    const size_t              *body_offsets,
+    size_t                     body_offset_count,
+    size_t                     body_size,
+    cstruct_dispatch_handler_f handler,
+    void                      *context);
+
+/// Return the size of the storage which cstruct_dispatch needs to decode any registered message.
+/// @param[in] dispatch The registry.
+/// @return The size of the storage, in bytes.
+size_t cstruct_dispatch_storage_size(const cstruct_dispatch_t *dispatch);
+
+/// Decode a message, and pass it to the handler for its type.
+/// @param[in] dispatch The registry.
+/// @param[in] buffer The buffer holding the packed message.
+/// @param[in] buffer_size The length of the buffer.
+/// @param[out] storage Storage for the decoded message, which must be aligned for any type. The
+///                     header is decoded to the start of the storage, and the body after it.
+/// @param[in] storage_size The length of the storage.
+/// @return The number of bytes decoded, or -1 if the message type is not registered, or an error
+///         occurred.
+ssize_t cstruct_dispatch(
+    const cstruct_dispatch_t *dispatch,
+    const void               *buffer,
+    size_t                    buffer_size,
+    void                     *storage,
+    size_t                    storage_size);
+
+/// Free a registry.
+/// @param[in] dispatch The registry, which may be NULL.
+void cstruct_dispatch_free(cstruct_dispatch_t *dispatch);
@@ -0,0 +1,918 @@
+#include "cstruct_io.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(CSTRUCT_HAVE_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "cstruct.h"
+
+// NOTE(Caleb): Alignment of each buffer, which also makes the buffers suitable for O_DIRECT files
+#define __CSTRUCT_IO_ALIGNMENT 4096
+
+// NOTE(Caleb): Number of submission queue entries; at most two operations are ever in flight
+#define __CSTRUCT_IO_URING_ENTRIES 4
+
+// NOTE(Caleb): Largest buffer size, since io_uring takes 32-bit lengths and returns a 32-bit result
+#define __CSTRUCT_IO_MAX_BUFFER_SIZE ((size_t)INT32_MAX)
+
+/// The state of one of the two buffers of a writer or reader.
+typedef enum
+{
+    __CSTRUCT_IO_IDLE,      // Free to be packed into
+    __CSTRUCT_IO_SUBMITTED, // Being written or read through io_uring
+    __CSTRUCT_IO_PENDING,   // Waiting to be written with pwritev
+    __CSTRUCT_IO_READY,     // Read, and ready to be unpacked from
+} __cstruct_io_state_t;
+
+/// A minimal io_uring instance, driven through raw system calls.
+typedef struct
+{
+    int fd; // -1 if io_uring is unavailable
+
+#if defined(CSTRUCT_HAVE_IO_URING)
+    unsigned            *sq_head;
+    unsigned            *sq_tail;
+    unsigned            *sq_mask;
+    unsigned            *sq_array;
+    unsigned            *cq_head;
+    unsigned            *cq_tail;
+    unsigned            *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+
+    void  *sq_ring;
+    void  *cq_ring;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    size_t sqes_size;
+#endif
+} __cstruct_uring_t;
+
+struct cstruct_writer
+{
+    int                  fd;
+    off_t                offset; // Offset in the file of the next buffer to be written
+    size_t               buffer_size;
+    uint8_t             *buffers[2];
+    size_t               lengths[2];
+    off_t                offsets[2];
+    __cstruct_io_state_t states[2];
+    unsigned             current;
+    bool                 error;
+    __cstruct_uring_t    uring;
+};
+
+struct cstruct_reader
+{
+    int                  fd;
+    off_t                offset; // Offset in the file of the next buffer to be read
+    size_t               buffer_size;
+    uint8_t             *buffers[2];
+    size_t               lengths[2];
+    off_t                offsets[2];
+    __cstruct_io_state_t states[2];
+    unsigned             current;
+    size_t               position; // Offset in the current buffer of the next record
+    bool                 eof;
+    bool                 error;
+    uint8_t             *scratch; // Holds records which straddle the two buffers
+    __cstruct_uring_t    uring;
+};
+
+/// Set up an io_uring instance, and register the given buffers with it.
+/// @param[out] uring The instance to set up. On failure, its fd is -1.
+/// @param[in] buffers The two buffers to register.
+/// @param[in] buffer_size The size of each buffer.
+/// @return 0 on success, or -1 if io_uring is unavailable.
+static int __cstruct_uring_init(__cstruct_uring_t *uring, uint8_t *buffers[2], size_t buffer_size);
+
+/// Tear down an io_uring instance, if it was set up.
+/// @param[inout] uring The instance.
+static void __cstruct_uring_free(__cstruct_uring_t *uring);
+
+/// Submit a read or write of one of the registered buffers.
+/// @param[inout] uring The instance.
+/// @param[in] write True to write the buffer to the file, or false to read the file into it.
+/// @param[in] fd The file.
+/// @param[in] index The index of the registered buffer, which is also returned on completion.
+/// @param[in] buffer The buffer.
+/// @param[in] length The number of bytes to write or read.
+/// @param[in] offset The offset in the file.
+/// @return 0 on success, or -1 if the operation wasn't submitted, in which case the kernel will
+///         never touch the buffer for it.
+static int __cstruct_uring_submit(
+    __cstruct_uring_t *uring,
+    bool               write,
+    int                fd,
+    unsigned           index,
+    void              *buffer,
+    size_t             length,
+    off_t              offset);
+
+/// Wait for the next completed read or write.
+/// @param[inout] uring The instance.
+/// @param[out] index The index of the buffer which was read or written.
+/// @param[out] result The number of bytes read or written, or a negated errno value.
+/// @return 0 on success, or -1 if an error occurred.
+static int __cstruct_uring_wait(__cstruct_uring_t *uring, unsigned *index, int32_t *result);
+
+/// Write every byte described by the given vectors, retrying after partial writes.
+/// @param[in] fd The file.
+/// @param[inout] iov The vectors, which are consumed as they are written.
+/// @param[in] count The number of vectors.
+/// @param[in] offset The offset in the file.
+/// @return 0 on success, or -1 if an error occurred.
+static int __cstruct_pwritev_all(int fd, struct iovec *iov, int count, off_t offset);
+
+/// Read until the buffer is full or the end of the file is reached, retrying after partial reads.
+/// @param[in] fd The file.
+/// @param[out] buffer The buffer.
+/// @param[in] length The length of the buffer.
+/// @param[in] offset The offset in the file.
+/// @return The number of bytes read, or -1 if an error occurred.
+static ssize_t __cstruct_pread_all(int fd, uint8_t *buffer, size_t length, off_t offset);
+
+/// Queue the current buffer of a writer to be written, and advance to the other buffer.
+/// @param[inout] writer The writer.
+static void __cstruct_writer_submit(cstruct_writer_t *writer);
+
+/// Wait until the given buffer of a writer has been written.
+/// @param[inout] writer The writer.
+/// @param[in] index The index of the buffer.
+static void __cstruct_writer_wait(cstruct_writer_t *writer, unsigned index);
+
+/// Start reading the next part of the file into the given buffer of a reader.
+/// @param[inout] reader The reader.
+/// @param[in] index The index of the buffer.
+static void __cstruct_reader_submit(cstruct_reader_t *reader, unsigned index);
+
+/// Wait until the given buffer of a reader has been read.
+/// @param[inout] reader The reader.
+/// @param[in] index The index of the buffer.
+static void __cstruct_reader_wait(cstruct_reader_t *reader, unsigned index);
+
+/// Record the result of a read into the given buffer of a reader.
+/// @param[inout] reader The reader.
+/// @param[in] index The index of the buffer.
+/// @param[in] result The number of bytes read, or a negated errno value.
+static void __cstruct_reader_complete(cstruct_reader_t *reader, unsigned index, ssize_t result);
+
+// Public API --------------------------------------------------------------------------------------
+
+cstruct_writer_t *cstruct_writer_open(int fd, off_t offset, size_t buffer_size)
+{
+    if (fd < 0 || buffer_size == 0 || buffer_size > __CSTRUCT_IO_MAX_BUFFER_SIZE)
+    {
+        return NULL;
+    }
+
+    cstruct_writer_t *writer = calloc(1, sizeof(*writer));
+    if (!writer)
+    {
+        return NULL;
+    }
+
+    writer->fd          = fd;
+    writer->offset      = offset;
+    writer->buffer_size = buffer_size;
+    writer->uring.fd    = -1;
+
+    for (unsigned i = 0; i < 2; i++)
+    {
+        void *buffer = NULL;
+        if (posix_memalign(&buffer, __CSTRUCT_IO_ALIGNMENT, buffer_size) != 0)
+        {
+            cstruct_writer_close(writer);
+            return NULL;
+        }
+
+        writer->buffers[i] = buffer;
+    }
+
+    // NOTE(Caleb): If io_uring is unavailable, fall back to pwritev
+    __cstruct_uring_init(&writer->uring, writer->buffers, buffer_size);
+
+    return writer;
+}
+
+ssize_t cstruct_writer_pack(cstruct_writer_t *writer, const char *format, ...)
+{
+    ssize_t size = cstruct_sizeof(format);
+    if (size < 0 || (size_t)size > writer->buffer_size)
+    {
+        return -1;
+    }
+
+    // NOTE(Caleb): If the record doesn't fit in the current buffer, queue that buffer to be written
+    // and pack into the other, now empty, buffer
+    if ((size_t)size > writer->buffer_size - writer->lengths[writer->current])
+    {
+        __cstruct_writer_submit(writer);
+    }
+
+    unsigned current = writer->current;
+
+    va_list args;
+    va_start(args, format);
+
+    ssize_t total_size = cstruct_vpack(
+        format,
+        writer->buffers[current] + writer->lengths[current],
+        writer->buffer_size - writer->lengths[current],
+        args);
+
+    va_end(args);
+
+    if (total_size >= 0)
+    {
+        writer->lengths[current] += total_size;
+    }
+
+    return total_size;
+}
+
+int cstruct_writer_flush(cstruct_writer_t *writer)
+{
+    if (writer->lengths[writer->current] > 0)
+    {
+        __cstruct_writer_submit(writer);
+    }
+
+    __cstruct_writer_wait(writer, 0);
+    __cstruct_writer_wait(writer, 1);
+
+    int result    = writer->error ? -1 : 0;
+    writer->error = false;
+
+    return result;
+}
+
+int cstruct_writer_close(cstruct_writer_t *writer)
+{
+    if (!writer)
+    {
+        return 0;
+    }
+
+    int result = 0;
+    if (writer->buffers[0] && writer->buffers[1])
+    {
+        result = cstruct_writer_flush(writer);
+    }
+
+    __cstruct_uring_free(&writer->uring);
+    free(writer->buffers[0]);
+    free(writer->buffers[1]);
+    free(writer);
+
+    return result;
+}
+
+cstruct_reader_t *cstruct_reader_open(int fd, off_t offset, size_t buffer_size)
+{
+    if (fd < 0 || buffer_size == 0 || buffer_size > __CSTRUCT_IO_MAX_BUFFER_SIZE)
+    {
+        return NULL;
+    }
+
+    cstruct_reader_t *reader = calloc(1, sizeof(*reader));
+    if (!reader)
+    {
+        return NULL;
+    }
+
+    reader->fd          = fd;
+    reader->offset      = offset;
+    reader->buffer_size = buffer_size;
+    reader->uring.fd    = -1;
+
+    for (unsigned i = 0; i < 2; i++)
+    {
+        void *buffer = NULL;
+        if (posix_memalign(&buffer, __CSTRUCT_IO_ALIGNMENT, buffer_size) != 0)
+        {
+            cstruct_reader_close(reader);
+            return NULL;
+        }
+
+        reader->buffers[i] = buffer;
+    }
+
+    reader->scratch = malloc(buffer_size);
+    if (!reader->scratch)
+    {
+        cstruct_reader_close(reader);
+        return NULL;
+    }
+
+    // NOTE(Caleb): If io_uring is unavailable, fall back to synchronous reads
+    __cstruct_uring_init(&reader->uring, reader->buffers, buffer_size);
+
+    // NOTE(Caleb): Start reading both buffers right away
+    __cstruct_reader_submit(reader, 0);
+    __cstruct_reader_submit(reader, 1);
+
+    return reader;
+}
+
+ssize_t cstruct_reader_unpack(cstruct_reader_t *reader, const char *format, ...)
+{
+    ssize_t size = cstruct_sizeof(format);
+    if (size <= 0 || (size_t)size > reader->buffer_size)
+    {
+        return -1;
+    }
+
+    unsigned current = reader->current;
+    __cstruct_reader_wait(reader, current);
+
+    if (reader->error)
+    {
+        return -1;
+    }
+
+    const uint8_t *src       = reader->buffers[current] + reader->position;
+    size_t         available = reader->lengths[current] - reader->position;
+
+    if (available >= (size_t)size)
+    {
+        reader->position += size;
+    }
+    else
+    {
+        unsigned next = current ^ 1;
+        __cstruct_reader_wait(reader, next);
+
+        if (reader->error)
+        {
+            return -1;
+        }
+
+        // NOTE(Caleb): If true, the file ends here, either cleanly or partway through a record
+        if (available + reader->lengths[next] < (size_t)size)
+        {
+            return available + reader->lengths[next] == 0 ? 0 : -1;
+        }
+
+        // NOTE(Caleb): A record which straddles both buffers is stitched together in the scratch
+        // buffer, so that the current buffer can be refilled straight away
+        if (available > 0)
+        {
+            memcpy(reader->scratch, src, available);
+            memcpy(reader->scratch + available, reader->buffers[next], size - available);
+            src = reader->scratch;
+        }
+        else
+        {
+            src = reader->buffers[next];
+        }
+
+        __cstruct_reader_submit(reader, current);
+
+        reader->current  = next;
+        reader->position = size - available;
+    }
+
+    va_list args;
+    va_start(args, format);
+
+    ssize_t bytes_read = cstruct_vunpack(format, src, size, args);
+
+    va_end(args);
+    return bytes_read;
+}
+
+void cstruct_reader_close(cstruct_reader_t *reader)
+{
+    if (!reader)
+    {
+        return;
+    }
+
+    for (unsigned i = 0; i < 2; i++)
+    {
+        if (reader->buffers[i])
+        {
+            __cstruct_reader_wait(reader, i);
+        }
+    }
+
+    __cstruct_uring_free(&reader->uring);
+    free(reader->buffers[0]);
+    free(reader->buffers[1]);
+    free(reader->scratch);
+    free(reader);
+}
+
+// Private Helpers ---------------------------------------------------------------------------------
+
+static int __cstruct_uring_init(__cstruct_uring_t *uring, uint8_t *buffers[2], size_t buffer_size)
+{
+    uring->fd = -1;
+
+#if defined(CSTRUCT_HAVE_IO_URING)
+    uring->sq_ring = MAP_FAILED;
+    uring->cq_ring = MAP_FAILED;
+    uring->sqes    = MAP_FAILED;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = (int)syscall(__NR_io_uring_setup, __CSTRUCT_IO_URING_ENTRIES, &params);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    uring->fd           = fd;
+    uring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    uring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    uring->sqes_size    = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    // NOTE(Caleb): Newer kernels map both rings with a single mmap
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap)
+    {
+        if (uring->cq_ring_size > uring->sq_ring_size)
+        {
+            uring->sq_ring_size = uring->cq_ring_size;
+        }
+
+        uring->cq_ring_size = uring->sq_ring_size;
+    }
+
+    uring->sq_ring = mmap(
+        NULL,
+        uring->sq_ring_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        fd,
+        IORING_OFF_SQ_RING);
+
+    if (single_mmap)
+    {
+        uring->cq_ring = uring->sq_ring;
+    }
+    else
+    {
+        uring->cq_ring = mmap(
+            NULL,
+            uring->cq_ring_size,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            fd,
+            IORING_OFF_CQ_RING);
+    }
+
+    uring->sqes = mmap(
+        NULL,
+        uring->sqes_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        fd,
+        IORING_OFF_SQES);
+
+    if (uring->sq_ring == MAP_FAILED || uring->cq_ring == MAP_FAILED || uring->sqes == MAP_FAILED)
+    {
+        __cstruct_uring_free(uring);
+        return -1;
+    }
+
+    uint8_t *sq_ring = uring->sq_ring;
+    uint8_t *cq_ring = uring->cq_ring;
+
+    uring->sq_head  = (unsigned *)(sq_ring + params.sq_off.head);
+    uring->sq_tail  = (unsigned *)(sq_ring + params.sq_off.tail);
+    uring->sq_mask  = (unsigned *)(sq_ring + params.sq_off.ring_mask);
+    uring->sq_array = (unsigned *)(sq_ring + params.sq_off.array);
+    uring->cq_head  = (unsigned *)(cq_ring + params.cq_off.head);
+    uring->cq_tail  = (unsigned *)(cq_ring + params.cq_off.tail);
+    uring->cq_mask  = (unsigned *)(cq_ring + params.cq_off.ring_mask);
+    uring->cqes     = (struct io_uring_cqe *)(cq_ring + params.cq_off.cqes);
+
+    // NOTE(Caleb): Registering the buffers up front saves the kernel from mapping them on every
+    // read and write
+    struct iovec iov[2] = {
+        {.iov_base = buffers[0], .iov_len = buffer_size},
+        {.iov_base = buffers[1], .iov_len = buffer_size},
+    };
+
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, iov, 2) < 0)
+    {
+        __cstruct_uring_free(uring);
+        return -1;
+    }
+
+    return 0;
+#else
+    (void)buffers;
+    (void)buffer_size;
+
+    return -1;
+#endif
+}
+
+static void __cstruct_uring_free(__cstruct_uring_t *uring)
+{
+#if defined(CSTRUCT_HAVE_IO_URING)
+    if (uring->fd < 0)
+    {
+        return;
+    }
+
+    if (uring->sqes != MAP_FAILED)
+    {
+        munmap(uring->sqes, uring->sqes_size);
+    }
+
+    if (uring->cq_ring != MAP_FAILED && uring->cq_ring != uring->sq_ring)
+    {
+        munmap(uring->cq_ring, uring->cq_ring_size);
+    }
+
+    if (uring->sq_ring != MAP_FAILED)
+    {
+        munmap(uring->sq_ring, uring->sq_ring_size);
+    }
+
+    close(uring->fd);
+#endif
+
+    uring->fd = -1;
+}
+
+static int __cstruct_uring_submit(
+    __cstruct_uring_t *uring,
+    bool               write,
+    int                fd,
+    unsigned           index,
+    void              *buffer,
+    size_t             length,
+    off_t              offset)
+{
+#if defined(CSTRUCT_HAVE_IO_URING)
+    // NOTE(Caleb): Only this thread writes the tail, but the kernel advances the head
+    unsigned tail = *uring->sq_tail;
+    unsigned head = __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+
+    if (tail - head > *uring->sq_mask)
+    {
+        return -1;
+    }
+
+    unsigned             slot = tail & *uring->sq_mask;
+    struct io_uring_sqe *sqe  = &uring->sqes[slot];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+    sqe->fd        = fd;
+    sqe->addr      = (uint64_t)(uintptr_t)buffer;
+    sqe->len       = (uint32_t)length;
+    sqe->off       = (uint64_t)offset;
+    sqe->buf_index = (uint16_t)index;
+    sqe->user_data = index;
+
+    uring->sq_array[slot] = slot;
+    __atomic_store_n(uring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    int submitted = 0;
+    do
+    {
+        submitted = (int)syscall(__NR_io_uring_enter, uring->fd, 1, 0, 0, NULL, 0);
+    } while (submitted < 0 && errno == EINTR);
+
+    // NOTE(Caleb): Withdraw an entry which the kernel didn't consume, so that a later
+    // io_uring_enter can't pick it up once the buffer has been written or read synchronously instead
+    if (submitted != 1 && __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) == tail)
+    {
+        __atomic_store_n(uring->sq_tail, tail, __ATOMIC_RELEASE);
+        return -1;
+    }
+
+    return 0;
+#else
+    (void)uring;
+    (void)write;
+    (void)fd;
+    (void)index;
+    (void)buffer;
+    (void)length;
+    (void)offset;
+
+    return -1;
+#endif
+}
+
+static int __cstruct_uring_wait(__cstruct_uring_t *uring, unsigned *index, int32_t *result)
+{
+#if defined(CSTRUCT_HAVE_IO_URING)
+    while (true)
+    {
+        unsigned head = *uring->cq_head;
+        unsigned tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+
+        if (head != tail)
+        {
+            struct io_uring_cqe *cqe = &uring->cqes[head & *uring->cq_mask];
+
+            *index  = (unsigned)cqe->user_data;
+            *result = cqe->res;
+
+            __atomic_store_n(uring->cq_head, head + 1, __ATOMIC_RELEASE);
+            return 0;
+        }
+
+        if (syscall(__NR_io_uring_enter, uring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0
+            && errno != EINTR)
+        {
+            return -1;
+        }
+    }
+#else
+    (void)uring;
+    (void)index;
+    (void)result;
+
+    return -1;
+#endif
+}
+
+static int __cstruct_pwritev_all(int fd, struct iovec *iov, int count, off_t offset)
+{
+    while (count > 0)
+    {
+        ssize_t written = pwritev(fd, iov, count, offset);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return -1;
+        }
+
+        offset += written;
+
+        // NOTE(Caleb): Skip past whatever was written, which may end partway through a vector
+        while (count > 0 && (size_t)written >= iov->iov_len)
+        {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+
+        if (count > 0)
+        {
+            iov->iov_base  = (uint8_t *)iov->iov_base + written;
+            iov->iov_len  -= written;
+        }
+    }
+
+    return 0;
+}
+
+static ssize_t __cstruct_pread_all(int fd, uint8_t *buffer, size_t length, off_t offset)
+{
+    size_t total = 0;
+
+    while (total < length)
+    {
+        ssize_t bytes_read = pread(fd, buffer + total, length - total, offset + total);
+        if (bytes_read < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return -1;
+        }
+
+        if (bytes_read == 0)
+        {
+            break;
+        }
+
+        total += bytes_read;
+    }
+
+    return total;
+}
+
+static void __cstruct_writer_submit(cstruct_writer_t *writer)
+{
+    unsigned current = writer->current;
+
+    writer->offsets[current]  = writer->offset;
+    writer->offset           += writer->lengths[current];
+    writer->states[current]   = __CSTRUCT_IO_PENDING;
+
+    if (writer->uring.fd >= 0)
+    {
+        if (__cstruct_uring_submit(
+                &writer->uring,
+                true,
+                writer->fd,
+                current,
+                writer->buffers[current],
+                writer->lengths[current],
+                writer->offsets[current])
+            == 0)
+        {
+            writer->states[current] = __CSTRUCT_IO_SUBMITTED;
+        }
+
+        // NOTE(Caleb): Otherwise the buffer stays pending, and is written with pwritev instead
+    }
+
+    // NOTE(Caleb): Packing continues in the other buffer, once its last write has finished
+    writer->current ^= 1;
+    __cstruct_writer_wait(writer, writer->current);
+}
+
+static void __cstruct_writer_wait(cstruct_writer_t *writer, unsigned index)
+{
+    while (writer->states[index] == __CSTRUCT_IO_SUBMITTED)
+    {
+        unsigned completed = 0;
+        int32_t  result    = 0;
+
+        if (__cstruct_uring_wait(&writer->uring, &completed, &result) < 0)
+        {
+            // NOTE(Caleb): No completion can be collected any more, so give up on every write still
+            // in flight, and on io_uring itself, so that later writes all go through pwritev
+            for (unsigned i = 0; i < 2; i++)
+            {
+                if (writer->states[i] == __CSTRUCT_IO_SUBMITTED)
+                {
+                    writer->states[i]  = __CSTRUCT_IO_IDLE;
+                    writer->lengths[i] = 0;
+                }
+            }
+
+            writer->error = true;
+            __cstruct_uring_free(&writer->uring);
+
+            break;
+        }
+
+        if (result < 0)
+        {
+            writer->error = true;
+        }
+        else if ((size_t)result < writer->lengths[completed])
+        {
+            // NOTE(Caleb): Finish a short write synchronously
+            struct iovec iov = {
+                .iov_base = writer->buffers[completed] + result,
+                .iov_len  = writer->lengths[completed] - result,
+            };
+
+            if (__cstruct_pwritev_all(writer->fd, &iov, 1, writer->offsets[completed] + result) < 0)
+            {
+                writer->error = true;
+            }
+        }
+
+        writer->states[completed]  = __CSTRUCT_IO_IDLE;
+        writer->lengths[completed] = 0;
+    }
+
+    if (writer->states[index] == __CSTRUCT_IO_PENDING)
+    {
+        // NOTE(Caleb): Without io_uring, buffers are left pending until one of them is needed
+        // again, and then every pending buffer is written with a single pwritev
+        struct iovec iov[2];
+        int          count = 0;
+        unsigned     first = writer->states[index ^ 1] == __CSTRUCT_IO_PENDING
+                            && writer->offsets[index ^ 1] < writer->offsets[index]
+                               ? index ^ 1
+                               : index;
+
+        for (unsigned i = first; count < 2 && writer->states[i] == __CSTRUCT_IO_PENDING; i ^= 1)
+        {
+            iov[count].iov_base = writer->buffers[i];
+            iov[count].iov_len  = writer->lengths[i];
+            count++;
+        }
+
+        if (__cstruct_pwritev_all(writer->fd, iov, count, writer->offsets[first]) < 0)
+        {
+            writer->error = true;
+        }
+
+        for (unsigned i = 0; i < 2; i++)
+        {
+            if (writer->states[i] == __CSTRUCT_IO_PENDING)
+            {
+                writer->states[i]  = __CSTRUCT_IO_IDLE;
+                writer->lengths[i] = 0;
+            }
+        }
+    }
+}
+
+static void __cstruct_reader_submit(cstruct_reader_t *reader, unsigned index)
+{
+    reader->offsets[index]  = reader->offset;
+    reader->offset         += reader->buffer_size;
+
+    if (reader->eof)
+    {
+        reader->states[index]  = __CSTRUCT_IO_READY;
+        reader->lengths[index] = 0;
+
+        return;
+    }
+
+    if (reader->uring.fd >= 0)
+    {
+        if (__cstruct_uring_submit(
+                &reader->uring,
+                false,
+                reader->fd,
+                index,
+                reader->buffers[index],
+                reader->buffer_size,
+                reader->offsets[index])
+            == 0)
+        {
+            reader->states[index] = __CSTRUCT_IO_SUBMITTED;
+            return;
+        }
+    }
+
+    // NOTE(Caleb): Without io_uring, the read is made synchronously
+    ssize_t result = __cstruct_pread_all(
+        reader->fd, reader->buffers[index], reader->buffer_size, reader->offsets[index]);
+    __cstruct_reader_complete(reader, index, result < 0 ? -errno : result);
+}
+
+static void __cstruct_reader_wait(cstruct_reader_t *reader, unsigned index)
+{
+    while (reader->states[index] == __CSTRUCT_IO_SUBMITTED)
+    {
+        unsigned completed = 0;
+        int32_t  result    = 0;
+
+        if (__cstruct_uring_wait(&reader->uring, &completed, &result) < 0)
+        {
+            // NOTE(Caleb): As for the writer, fail every read still in flight and drop io_uring
+            for (unsigned i = 0; i < 2; i++)
+            {
+                if (reader->states[i] == __CSTRUCT_IO_SUBMITTED)
+                {
+                    __cstruct_reader_complete(reader, i, -EIO);
+                }
+            }
+
+            __cstruct_uring_free(&reader->uring);
+
+            break;
+        }
+
+        // NOTE(Caleb): A short read may just be interrupted, so top the buffer up synchronously
+        if (result >= 0 && (size_t)result < reader->buffer_size)
+        {
+            ssize_t rest = __cstruct_pread_all(
+                reader->fd,
+                reader->buffers[completed] + result,
+                reader->buffer_size - result,
+                reader->offsets[completed] + result);
+
+            result = rest < 0 ? -errno : result + (int32_t)rest;
+        }
+
+        __cstruct_reader_complete(reader, completed, result);
+    }
+}
+
+static void __cstruct_reader_complete(cstruct_reader_t *reader, unsigned index, ssize_t result)
+{
+    if (result < 0)
+    {
+        reader->error = true;
+        result        = 0;
+    }
+
+    // NOTE(Caleb): A read which comes up short has reached the end of the file
+    if ((size_t)result < reader->buffer_size)
+    {
+        reader->eof = true;
+    }
+
+    reader->states[index]  = __CSTRUCT_IO_READY;
+    reader->lengths[index] = result;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/// A batched writer of packed records to a file.
+/// @note Records are packed into one of two buffers. Once a buffer is full, it is written to the
+///       file asynchronously while records are packed into the other one. Writes are made with
+///       io_uring when it is available, and with pwritev otherwise.
+typedef struct cstruct_writer cstruct_writer_t;
+
+/// A batched reader of packed records from a file.
+/// @note Records are unpacked from one of two buffers, while the next part of the file is read into
+///       the other one asynchronously. Reads are made with io_uring when it is available, and
+///       synchronously otherwise.
+typedef struct cstruct_reader cstruct_reader_t;
+
+/// Open a writer which packs records into the given file.
+/// @param[in] fd The file to write to, which remains owned by the caller.
+/// @param[in] offset The offset in the file at which to write the first record.
+/// @param[in] buffer_size The size of each of the two buffers, and so the size of each write. It
+///                        must be less than 2 GiB.
+/// @return The writer, or NULL if an error occurred.
+cstruct_writer_t *cstruct_writer_open(int fd, off_t offset, size_t buffer_size);
+
+/// Pack a record according to the format string, and queue it to be written.
+/// @param[inout] writer The writer.
+/// @param[in] format The format string describing the data layout.
+/// @param[in] ... The values to pack, corresponding to the format string.
+/// @return The number of bytes packed, or -1 if an error occurred.
+ssize_t cstruct_writer_pack(cstruct_writer_t *writer, const char *format, ...);
+
+/// Write every queued record, and wait for all writes to finish.
+/// @param[inout] writer The writer.
+/// @return 0 on success, or -1 if any write since the last flush failed.
+int cstruct_writer_flush(cstruct_writer_t *writer);
+
+/// Flush and close a writer.
+/// @param[in] writer The writer, which may be NULL.
+/// @return 0 on success, or -1 if any write since the last flush failed.
+int cstruct_writer_close(cstruct_writer_t *writer);
+
+/// Open a reader which unpacks records from the given file.
+/// @param[in] fd The file to read from, which remains owned by the caller.
+/// @param[in] offset The offset in the file of the first record.
+/// @param[in] buffer_size The size of each of the two buffers, and so the size of each read. No
+///                        record may be larger than this, and it must be less than 2 GiB.
+/// @return The reader, or NULL if an error occurred.
+cstruct_reader_t *cstruct_reader_open(int fd, off_t offset, size_t buffer_size);
+
+/// Unpack the next record according to the format string.
+/// @param[inout] reader The reader.
+/// @param[in] format The format string describing the data layout.
+/// @param[out] ... Pointers to variables where the unpacked values will be stored.
+/// @return The number of bytes unpacked, 0 at the end of the file, or -1 if an error occurred.
+ssize_t cstruct_reader_unpack(cstruct_reader_t *reader, const char *format, ...);
+
+/// Close a reader, waiting for any outstanding read to finish.
+/// @param[in] reader The reader, which may be NULL.
+void cstruct_reader_close(cstruct_reader_t *reader);
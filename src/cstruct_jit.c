@@ -0,0 +1,655 @@
+#include "cstruct_jit.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(CSTRUCT_HAVE_JIT)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "cstruct.h"
+
+// NOTE(Caleb): Largest amount of code generated for a single format string; anything bigger, such
+// as a format string with a huge `s` string, is left to the interpreter
+#define __CSTRUCT_JIT_MAX_CODE_SIZE (1024 * 1024)
+
+// NOTE(Caleb): x86-64 register numbers of the two arguments of a generated routine, under the
+// System V calling convention
+#define __CSTRUCT_JIT_RDI 7 // The packed blob
+#define __CSTRUCT_JIT_RSI 6 // The struct
+
+/// A generated routine, which transfers values between a packed blob and a struct.
+typedef void (*__cstruct_jit_routine_f)(uint8_t *packed, uint8_t *object);
+
+struct cstruct_jit
+{
+    char   *format;
+    size_t *offsets;
+    size_t  offset_count;
+    size_t  size;    // The size of the packed blob
+    bool    overlay; // True if the packed blob is laid out exactly like the struct
+
+    cstruct_field_t *padding;       // The runs of padding, which an overlay zeroes or skips
+    size_t           padding_count;
+
+    void                   *code;      // The executable pages, or NULL if not compiled
+    size_t                  code_size; // The length of the executable pages
+    __cstruct_jit_routine_f pack;
+    __cstruct_jit_routine_f unpack;
+};
+
+/// A growable buffer of machine code.
+typedef struct
+{
+    uint8_t *data;
+    size_t   size;
+    size_t   capacity;
+    bool     failed; // True if the code grew too large, or memory ran out
+} __cstruct_jit_buffer_t;
+
+#if defined(CSTRUCT_HAVE_JIT)
+
+/// Append bytes to a code buffer.
+/// @param[inout] buffer The code buffer.
+/// @param[in] bytes The bytes to append.
+/// @param[in] n The number of bytes to append.
+static void __cstruct_jit_emit(__cstruct_jit_buffer_t *buffer, const uint8_t *bytes, size_t n);
+
+/// Append the ModRM byte and 32-bit displacement which address [base + disp], with rax as the
+/// other operand.
+/// @param[inout] buffer The code buffer.
+/// @param[in] base The register number of the base register.
+/// @param[in] disp The displacement.
+static void __cstruct_jit_emit_address(__cstruct_jit_buffer_t *buffer, int base, uint32_t disp);
+
+/// Append an instruction which loads a value from [base + disp] into rax, zero extended.
+/// @param[inout] buffer The code buffer.
+/// @param[in] width The size of the value in bytes (1, 2, 4, or 8).
+/// @param[in] base The register number of the base register.
+/// @param[in] disp The displacement.
+static void __cstruct_jit_emit_load(
+    __cstruct_jit_buffer_t *buffer, size_t width, int base, uint32_t disp);
+
+/// Append an instruction which stores the low bytes of rax to [base + disp].
+/// @param[inout] buffer The code buffer.
+/// @param[in] width The size of the value in bytes (1, 2, 4, or 8).
+/// @param[in] base The register number of the base register.
+/// @param[in] disp The displacement.
+static void __cstruct_jit_emit_store(
+    __cstruct_jit_buffer_t *buffer, size_t width, int base, uint32_t disp);
+
+/// Append an instruction which reverses the byte order of the low bytes of rax.
+/// @param[inout] buffer The code buffer.
+/// @param[in] width The size of the value in bytes (2, 4, or 8).
+static void __cstruct_jit_emit_bswap(__cstruct_jit_buffer_t *buffer, size_t width);
+
+/// Append instructions which copy a run of bytes, as is, from [src + src_disp] to
+/// [dest + dest_disp].
+/// @param[inout] buffer The code buffer.
+/// @param[in] src The register number of the source base register.
+/// @param[in] src_disp The source displacement.
+/// @param[in] dest The register number of the destination base register.
+/// @param[in] dest_disp The destination displacement.
+/// @param[in] size The number of bytes to copy.
+static void __cstruct_jit_emit_copy(
+    __cstruct_jit_buffer_t *buffer,
+    int                     src,
+    uint32_t                src_disp,
+    int                     dest,
+    uint32_t                dest_disp,
+    size_t                  size);
+
+/// Append instructions which zero a run of bytes at [base + disp].
+/// @param[inout] buffer The code buffer.
+/// @param[in] base The register number of the base register.
+/// @param[in] disp The displacement.
+/// @param[in] size The number of bytes to zero.
+static void __cstruct_jit_emit_zero(
+    __cstruct_jit_buffer_t *buffer, int base, uint32_t disp, size_t size);
+
+/// Append a straight-line routine which packs or unpacks every field of a format string.
+/// @param[inout] buffer The code buffer.
+/// @param[in] fields The fields of the format string.
+/// @param[in] field_count The number of fields.
+/// @param[in] offsets The offset of each value within the struct.
+/// @param[in] swap True if multi-byte values must have their byte order reversed.
+/// @param[in] key True if signed integers must have their sign bit flipped, for `^` keys.
+/// @param[in] pack True to generate the packing routine, or false for the unpacking routine.
+static void __cstruct_jit_emit_routine(
+    __cstruct_jit_buffer_t *buffer,
+    const cstruct_field_t  *fields,
+    size_t                  field_count,
+    const size_t           *offsets,
+    bool                    swap,
+    bool                    key,
+    bool                    pack);
+
+/// Generate the packing and unpacking routines for a compiled format, and map them into executable
+/// pages. If the format can't be compiled, the compiled format is left to use the interpreter.
+/// @param[inout] jit The compiled format.
+/// @param[in] fields The fields of the format string.
+/// @param[in] field_count The number of fields.
+static void __cstruct_jit_generate(
+    cstruct_jit_t *jit, const cstruct_field_t *fields, size_t field_count);
+
+#endif
+
+// Public API --------------------------------------------------------------------------------------
+
+cstruct_jit_t *cstruct_jit_compile(const char *format, const size_t *offsets, size_t offset_count)
+{
+    ssize_t size        = cstruct_sizeof(format);
+    ssize_t field_count = cstruct_fields(format, NULL, 0);
+    if (size < 0 || field_count < 0 || (!offsets && offset_count > 0))
+    {
+        return NULL;
+    }
+
+    cstruct_field_t *fields = malloc(((size_t)field_count + 1) * sizeof(*fields));
+    if (!fields)
+    {
+        return NULL;
+    }
+
+    cstruct_fields(format, fields, (size_t)field_count);
+
+    // NOTE(Caleb): Every value needs exactly one offset
+    size_t value_count = 0;
+    for (ssize_t i = 0; i < field_count; i++)
+    {
+        value_count += fields[i].format_char != 'x';
+    }
+
+    cstruct_jit_t *jit = calloc(1, sizeof(*jit));
+    if (value_count != offset_count || !jit)
+    {
+        free(fields);
+        free(jit);
+
+        return NULL;
+    }
+
+    size_t format_length = strlen(format);
+
+    jit->format       = malloc(format_length + 1);
+    jit->offsets      = malloc((offset_count + 1) * sizeof(*offsets));
+    jit->offset_count = offset_count;
+    jit->size         = size;
+
+    if (!jit->format || !jit->offsets)
+    {
+        free(fields);
+        cstruct_jit_free(jit);
+
+        return NULL;
+    }
+
+    memcpy(jit->format, format, format_length + 1);
+    if (offset_count > 0)
+    {
+        memcpy(jit->offsets, offsets, offset_count * sizeof(*offsets));
+    }
+
+    // NOTE(Caleb): The struct is known to extend at least to the end of its last packed member
+    size_t object_size = 0;
+    for (ssize_t i = 0, value = 0; i < field_count; i++)
+    {
+        if (fields[i].format_char != 'x')
+        {
+            size_t end  = offsets[value++] + fields[i].size;
+            object_size = end > object_size ? end : object_size;
+        }
+    }
+
+    jit->overlay = cstruct_is_overlay(format, offsets, offset_count, object_size);
+
+    // NOTE(Caleb): The fields are no longer needed once compiled, so the padding is kept in place
+    if (jit->overlay)
+    {
+        for (ssize_t i = 0; i < field_count; i++)
+        {
+            if (fields[i].format_char == 'x')
+            {
+                fields[jit->padding_count++] = fields[i];
+            }
+        }
+
+        jit->padding = fields;
+        fields       = NULL;
+    }
+
+#if defined(CSTRUCT_HAVE_JIT)
+    if (!jit->overlay)
+    {
+        __cstruct_jit_generate(jit, fields, field_count);
+    }
+#endif
+
+    free(fields);
+    return jit;
+}
+
+bool cstruct_jit_is_native(const cstruct_jit_t *jit)
+{
+    return jit && (jit->code || jit->overlay);
+}
+
+ssize_t cstruct_jit_pack(
+    const cstruct_jit_t *jit, void *buffer, size_t buffer_size, const void *object)
+{
+    if (!jit || !buffer || !object)
+    {
+        return -1;
+    }
+
+    if (!jit->code && !jit->overlay)
+    {
+        return cstruct_pack_struct(
+            jit->format, buffer, buffer_size, object, jit->offsets, jit->offset_count);
+    }
+
+    if (buffer_size < jit->size)
+    {
+        return -1;
+    }
+
+    if (jit->overlay)
+    {
+        memcpy(buffer, object, jit->size);
+
+        // NOTE(Caleb): Padding holds whatever the struct does, so it is cleared afterwards
+        for (size_t i = 0; i < jit->padding_count; i++)
+        {
+            memset((uint8_t *)buffer + jit->padding[i].offset, 0, jit->padding[i].size);
+        }
+    }
+    else
+    {
+        jit->pack(buffer, (uint8_t *)object);
+    }
+
+    return jit->size;
+}
+
+ssize_t cstruct_jit_unpack(
+    const cstruct_jit_t *jit, const void *buffer, size_t buffer_size, void *object)
+{
+    if (!jit || !buffer || !object)
+    {
+        return -1;
+    }
+
+    if (!jit->code && !jit->overlay)
+    {
+        return cstruct_unpack_struct(
+            jit->format, buffer, buffer_size, object, jit->offsets, jit->offset_count);
+    }
+
+    if (buffer_size < jit->size)
+    {
+        return -1;
+    }
+
+    if (jit->overlay)
+    {
+        // NOTE(Caleb): Copy the values between runs of padding, which may lie over members of the
+        // struct that aren't packed
+        size_t start = 0;
+        for (size_t i = 0; i < jit->padding_count; i++)
+        {
+            memcpy(
+                (uint8_t *)object + start,
+                (const uint8_t *)buffer + start,
+                jit->padding[i].offset - start);
+            start = jit->padding[i].offset + jit->padding[i].size;
+        }
+
+        memcpy((uint8_t *)object + start, (const uint8_t *)buffer + start, jit->size - start);
+    }
+    else
+    {
+        // NOTE(Caleb): The unpacking routine only ever reads from the packed blob
+        jit->unpack((uint8_t *)buffer, object);
+    }
+
+    return jit->size;
+}
+
+void cstruct_jit_free(cstruct_jit_t *jit)
+{
+    if (!jit)
+    {
+        return;
+    }
+
+#if defined(CSTRUCT_HAVE_JIT)
+    if (jit->code)
+    {
+        munmap(jit->code, jit->code_size);
+    }
+#endif
+
+    free(jit->format);
+    free(jit->offsets);
+    free(jit->padding);
+    free(jit);
+}
+
+// Private Helpers ---------------------------------------------------------------------------------
+
+#if defined(CSTRUCT_HAVE_JIT)
+
+static void __cstruct_jit_emit(__cstruct_jit_buffer_t *buffer, const uint8_t *bytes, size_t n)
+{
+    if (buffer->failed)
+    {
+        return;
+    }
+
+    if (buffer->size + n > __CSTRUCT_JIT_MAX_CODE_SIZE)
+    {
+        buffer->failed = true;
+        return;
+    }
+
+    if (buffer->size + n > buffer->capacity)
+    {
+        size_t   capacity = buffer->capacity ? buffer->capacity * 2 : 256;
+        uint8_t *data     = realloc(buffer->data, capacity);
+        if (!data)
+        {
+            buffer->failed = true;
+            return;
+        }
+
+        buffer->data     = data;
+        buffer->capacity = capacity;
+    }
+
+    memcpy(buffer->data + buffer->size, bytes, n);
+    buffer->size += n;
+}
+
+static void __cstruct_jit_emit_address(__cstruct_jit_buffer_t *buffer, int base, uint32_t disp)
+{
+    // NOTE(Caleb): mod = 10 selects a 32-bit displacement, and reg = 000 selects rax. Neither rdi
+    // nor rsi needs a SIB byte as a base register.
+    const uint8_t bytes[5] = {
+        (uint8_t)(0x80 | base),
+        (uint8_t)(disp & 0xFF),
+        (uint8_t)((disp >> 8) & 0xFF),
+        (uint8_t)((disp >> 16) & 0xFF),
+        (uint8_t)(disp >> 24),
+    };
+
+    __cstruct_jit_emit(buffer, bytes, sizeof(bytes));
+}
+
+static void __cstruct_jit_emit_load(
+    __cstruct_jit_buffer_t *buffer, size_t width, int base, uint32_t disp)
+{
+    static const uint8_t movzx8[]  = {0x0F, 0xB6}; // movzx eax, byte [...]
+    static const uint8_t movzx16[] = {0x0F, 0xB7}; // movzx eax, word [...]
+    static const uint8_t mov32[]   = {0x8B};       // mov eax, dword [...]
+    static const uint8_t mov64[]   = {0x48, 0x8B}; // mov rax, qword [...]
+
+    switch (width)
+    {
+        case 1:
+            __cstruct_jit_emit(buffer, movzx8, sizeof(movzx8));
+            break;
+
+        case 2:
+            __cstruct_jit_emit(buffer, movzx16, sizeof(movzx16));
+            break;
+
+        case 4:
+            __cstruct_jit_emit(buffer, mov32, sizeof(mov32));
+            break;
+
+        default:
+            __cstruct_jit_emit(buffer, mov64, sizeof(mov64));
+            break;
+    }
+
+    __cstruct_jit_emit_address(buffer, base, disp);
+}
+
+static void __cstruct_jit_emit_store(
+    __cstruct_jit_buffer_t *buffer, size_t width, int base, uint32_t disp)
+{
+    static const uint8_t mov8[]  = {0x88};       // mov byte [...], al
+    static const uint8_t mov16[] = {0x66, 0x89}; // mov word [...], ax
+    static const uint8_t mov32[] = {0x89};       // mov dword [...], eax
+    static const uint8_t mov64[] = {0x48, 0x89}; // mov qword [...], rax
+
+    switch (width)
+    {
+        case 1:
+            __cstruct_jit_emit(buffer, mov8, sizeof(mov8));
+            break;
+
+        case 2:
+            __cstruct_jit_emit(buffer, mov16, sizeof(mov16));
+            break;
+
+        case 4:
+            __cstruct_jit_emit(buffer, mov32, sizeof(mov32));
+            break;
+
+        default:
+            __cstruct_jit_emit(buffer, mov64, sizeof(mov64));
+            break;
+    }
+
+    __cstruct_jit_emit_address(buffer, base, disp);
+}
+
+static void __cstruct_jit_emit_bswap(__cstruct_jit_buffer_t *buffer, size_t width)
+{
+    static const uint8_t rol16[]   = {0x66, 0xC1, 0xC0, 0x08}; // rol ax, 8
+    static const uint8_t bswap32[] = {0x0F, 0xC8};             // bswap eax
+    static const uint8_t bswap64[] = {0x48, 0x0F, 0xC8};       // bswap rax
+
+    switch (width)
+    {
+        case 2:
+            __cstruct_jit_emit(buffer, rol16, sizeof(rol16));
+            break;
+
+        case 4:
+            __cstruct_jit_emit(buffer, bswap32, sizeof(bswap32));
+            break;
+
+        case 8:
+            __cstruct_jit_emit(buffer, bswap64, sizeof(bswap64));
+            break;
+    }
+}
+
+static void __cstruct_jit_emit_copy(
+    __cstruct_jit_buffer_t *buffer,
+    int                     src,
+    uint32_t                src_disp,
+    int                     dest,
+    uint32_t                dest_disp,
+    size_t                  size)
+{
+    size_t copied = 0;
+
+    // NOTE(Caleb): Copy in the widest moves that fit, e.g. 8 + 4 + 2 + 1 bytes for a 15 byte run
+    for (size_t width = 8; width > 0; width /= 2)
+    {
+        for (; copied + width <= size; copied += width)
+        {
+            __cstruct_jit_emit_load(buffer, width, src, src_disp + copied);
+            __cstruct_jit_emit_store(buffer, width, dest, dest_disp + copied);
+        }
+    }
+}
+
+static void __cstruct_jit_emit_zero(
+    __cstruct_jit_buffer_t *buffer, int base, uint32_t disp, size_t size)
+{
+    static const uint8_t xor32[] = {0x31, 0xC0}; // xor eax, eax
+
+    __cstruct_jit_emit(buffer, xor32, sizeof(xor32));
+
+    size_t zeroed = 0;
+
+    for (size_t width = 8; width > 0; width /= 2)
+    {
+        for (; zeroed + width <= size; zeroed += width)
+        {
+            __cstruct_jit_emit_store(buffer, width, base, disp + zeroed);
+        }
+    }
+}
+
+static void __cstruct_jit_emit_routine(
+    __cstruct_jit_buffer_t *buffer,
+    const cstruct_field_t  *fields,
+    size_t                  field_count,
+    const size_t           *offsets,
+    bool                    swap,
+    bool                    key,
+    bool                    pack)
+{
+    static const uint8_t ret[]      = {0xC3};
+    static const uint8_t xor_sign[] = {0x34, 0x80}; // xor al, 0x80
+
+    size_t value = 0;
+
+    for (size_t i = 0; i < field_count; i++)
+    {
+        const cstruct_field_t *field = &fields[i];
+
+        if (field->format_char == 'x')
+        {
+            if (pack)
+            {
+                __cstruct_jit_emit_zero(buffer, __CSTRUCT_JIT_RDI, field->offset, field->size);
+            }
+
+            continue;
+        }
+
+        uint32_t packed_disp = field->offset;
+        uint32_t object_disp = offsets[value++];
+
+        int      src       = pack ? __CSTRUCT_JIT_RSI : __CSTRUCT_JIT_RDI;
+        uint32_t src_disp  = pack ? object_disp : packed_disp;
+        int      dest      = pack ? __CSTRUCT_JIT_RDI : __CSTRUCT_JIT_RSI;
+        uint32_t dest_disp = pack ? packed_disp : object_disp;
+
+        if (field->format_char == 's')
+        {
+            __cstruct_jit_emit_copy(buffer, src, src_disp, dest, dest_disp, field->size);
+            continue;
+        }
+
+        // NOTE(Caleb): The sign bit of a key is flipped while al holds the first packed byte, which
+        // is after the swap when packing, and before it when unpacking
+        bool flip = key && field->format_char >= 'a';
+
+        __cstruct_jit_emit_load(buffer, field->size, src, src_disp);
+        if (flip && !pack)
+        {
+            __cstruct_jit_emit(buffer, xor_sign, sizeof(xor_sign));
+        }
+        if (swap)
+        {
+            __cstruct_jit_emit_bswap(buffer, field->size);
+        }
+        if (flip && pack)
+        {
+            __cstruct_jit_emit(buffer, xor_sign, sizeof(xor_sign));
+        }
+        __cstruct_jit_emit_store(buffer, field->size, dest, dest_disp);
+    }
+
+    __cstruct_jit_emit(buffer, ret, sizeof(ret));
+}
+
+static void __cstruct_jit_generate(
+    cstruct_jit_t *jit, const cstruct_field_t *fields, size_t field_count)
+{
+    // NOTE(Caleb): Every displacement must fit in a signed 32-bit immediate
+    if (jit->size > INT32_MAX)
+    {
+        return;
+    }
+
+    for (size_t i = 0, value = 0; i < field_count; i++)
+    {
+        if (fields[i].format_char != 'x')
+        {
+            size_t offset = jit->offsets[value++];
+            if (offset > INT32_MAX || fields[i].size > INT32_MAX - offset)
+            {
+                return;
+            }
+        }
+    }
+
+    // NOTE(Caleb): The host is always little-endian, so only big-endian formats need swapping
+    char prefix = jit->format[0];
+    bool swap   = prefix != '<' && prefix != '@' && prefix != '=';
+    bool key    = prefix == '^';
+
+    // NOTE(Caleb): The key transform of floating point values depends on their sign, so it is left
+    // to the interpreter rather than generated
+    for (size_t i = 0; key && i < field_count; i++)
+    {
+        if (fields[i].format_char == 'f' || fields[i].format_char == 'd')
+        {
+            return;
+        }
+    }
+
+    __cstruct_jit_buffer_t buffer = {0};
+
+    __cstruct_jit_emit_routine(&buffer, fields, field_count, jit->offsets, swap, key, true);
+    size_t unpack_start = buffer.size;
+    __cstruct_jit_emit_routine(&buffer, fields, field_count, jit->offsets, swap, key, false);
+
+    if (buffer.failed)
+    {
+        free(buffer.data);
+        return;
+    }
+
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t code_size = (buffer.size + page_size - 1) / page_size * page_size;
+
+    uint8_t *code =
+        mmap(NULL, code_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED)
+    {
+        free(buffer.data);
+        return;
+    }
+
+    memcpy(code, buffer.data, buffer.size);
+    free(buffer.data);
+
+    // NOTE(Caleb): The pages are never writable and executable at the same time
+    if (mprotect(code, code_size, PROT_READ | PROT_EXEC) != 0)
+    {
+        munmap(code, code_size);
+        return;
+    }
+
+    jit->code      = code;
+    jit->code_size = code_size;
+
+    // NOTE(Caleb): ISO C has no cast from an object pointer to a function pointer, but POSIX
+    // guarantees that they share a representation
+    uint8_t *unpack = code + unpack_start;
+    memcpy(&jit->pack, &code, sizeof(jit->pack));
+    memcpy(&jit->unpack, &unpack, sizeof(jit->unpack));
+}
+
+#endif
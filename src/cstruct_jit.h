@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/// A format string compiled, along with the offsets of a struct, into native code which packs and
+/// unpacks that struct.
+/// @note If the packed blob is laid out exactly like the struct (see cstruct_is_overlay), packing
+///       and unpacking are a single memcpy, which skips or zeroes any padding. Otherwise, native code is generated for x86-64 Linux.
+///       Elsewhere, or if a format string can't be compiled, the compiled format falls back to
+///       cstruct_pack_struct and cstruct_unpack_struct, so it can always be used.
+typedef struct cstruct_jit cstruct_jit_t;
+
+/// Compile a format string for the struct with the given offsets.
+/// @param[in] format The format string describing the data layout.
+/// @param[in] offsets The offset of each value within the struct, as for cstruct_pack_struct. To
+///                    pack an array of values, pass the offset of each element of the array.
+/// @param[in] offset_count The number of offsets.
+/// @return The compiled format, or NULL if the format string or offsets are invalid, or an error
+///         occurred.
+cstruct_jit_t *cstruct_jit_compile(const char *format, const size_t *offsets, size_t offset_count);
+
+/// Return true if the format runs without the interpreter, either as native code or, if the packed
+/// blob is laid out exactly like the struct, as a single memcpy.
+/// @param[in] jit The compiled format.
+/// @return True if the format runs without the interpreter, and false otherwise.
+bool cstruct_jit_is_native(const cstruct_jit_t *jit);
+
+/// Pack the members of a struct into a binary blob with a compiled format.
+/// @param[in] jit The compiled format.
+/// @param[out] buffer The buffer to pack the data into.
+/// @param[in] buffer_size The length of the buffer.
+/// @param[in] object The struct to pack.
+/// @return The number of bytes packed, or -1 if the buffer is too small.
+ssize_t cstruct_jit_pack(
+    const cstruct_jit_t *jit, void *buffer, size_t buffer_size, const void *object);
+
+/// Unpack values from a binary blob into the members of a struct with a compiled format.
+/// @param[in] jit The compiled format.
+/// @param[in] buffer The buffer to unpack the data from.
+/// @param[in] buffer_size The length of the buffer.
+/// @param[out] object The struct to unpack into.
+/// @return The number of bytes unpacked, or -1 if the buffer is too small.
+ssize_t cstruct_jit_unpack(
+    const cstruct_jit_t *jit, const void *buffer, size_t buffer_size, void *object);
+
+/// Free a compiled format.
+/// @param[in] jit The compiled format, which may be NULL.
+void cstruct_jit_free(cstruct_jit_t *jit);
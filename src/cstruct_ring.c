@@ -0,0 +1,243 @@
+#include "cstruct_ring.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cstruct.h"
+
+/// The header at the start of every slot, followed by the packed message itself.
+typedef struct
+{
+    // NOTE(Caleb): Equal to the position of the slot while it is free, one more than that once it
+    // is committed, and advanced by a full lap of the ring once it is released
+    atomic_size_t sequence;
+    size_t        length;
+} __cstruct_ring_slot_t;
+
+/// Return the size of a slot, including its header, rounded up to a whole number of cache lines.
+/// @param[in] slot_capacity The maximum size of a single packed message.
+/// @return The size of a slot, or 0 if it would overflow.
+static inline size_t __cstruct_ring_slot_stride(size_t slot_capacity);
+
+/// Return the slot header for the given position in the ring.
+/// @param[in] ring The ring.
+/// @param[in] position The position, which wraps around the ring.
+/// @return The slot header.
+static inline __cstruct_ring_slot_t *__cstruct_ring_slot_at(cstruct_ring_t *ring, size_t position);
+
+// Public API --------------------------------------------------------------------------------------
+
+size_t cstruct_ring_storage_size(size_t slot_count, size_t slot_capacity)
+{
+    size_t slot_stride = __cstruct_ring_slot_stride(slot_capacity);
+    if (slot_stride == 0 || slot_count > SIZE_MAX / slot_stride)
+    {
+        return 0;
+    }
+
+    return slot_count * slot_stride;
+}
+
+int cstruct_ring_init(
+    cstruct_ring_t     *ring,
+    void               *storage,
+    size_t              storage_size,
+    size_t              slot_capacity,
+    cstruct_ring_mode_t mode)
+{
+    if (!ring || !storage || slot_capacity == 0)
+    {
+        return -1;
+    }
+
+    if ((uintptr_t)storage % CSTRUCT_RING_CACHE_LINE != 0)
+    {
+        return -1;
+    }
+
+    size_t slot_stride = __cstruct_ring_slot_stride(slot_capacity);
+    if (slot_stride == 0 || storage_size < slot_stride)
+    {
+        return -1;
+    }
+
+    // NOTE(Caleb): Round the slot count down to a power of two so that positions wrap with a mask
+    size_t slot_count = 1;
+    while (slot_count * 2 <= storage_size / slot_stride)
+    {
+        slot_count *= 2;
+    }
+
+    ring->slots         = storage;
+    ring->slot_count    = slot_count;
+    ring->slot_stride   = slot_stride;
+    ring->slot_capacity = slot_capacity;
+    ring->mode          = mode;
+
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        __cstruct_ring_slot_t *slot = __cstruct_ring_slot_at(ring, i);
+
+        atomic_init(&slot->sequence, i);
+        slot->length = 0;
+    }
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+
+    return 0;
+}
+
+void *cstruct_ring_reserve(cstruct_ring_t *ring)
+{
+    size_t position = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    while (true)
+    {
+        __cstruct_ring_slot_t *slot = __cstruct_ring_slot_at(ring, position);
+
+        size_t    sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        ptrdiff_t distance = (ptrdiff_t)(sequence - position);
+
+        if (distance == 0)
+        {
+            // NOTE(Caleb): A single producer owns the head outright, so it can skip the CAS
+            if (ring->mode == CSTRUCT_RING_SPSC)
+            {
+                atomic_store_explicit(&ring->head, position + 1, memory_order_relaxed);
+                return slot + 1;
+            }
+
+            // NOTE(Caleb): On failure, position is reloaded with the current head
+            if (atomic_compare_exchange_weak_explicit(
+                    &ring->head, &position, position + 1, memory_order_relaxed,
+                    memory_order_relaxed))
+            {
+                return slot + 1;
+            }
+        }
+        else if (distance < 0)
+        {
+            // NOTE(Caleb): The slot has not been released since the last lap, so the ring is full
+            return NULL;
+        }
+        else
+        {
+            // NOTE(Caleb): Another producer reserved this slot first
+            position = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+}
+
+void cstruct_ring_commit(cstruct_ring_t *ring, void *slot, size_t length)
+{
+    (void)ring;
+
+    __cstruct_ring_slot_t *header = (__cstruct_ring_slot_t *)slot - 1;
+    header->length                = length;
+
+    size_t sequence = atomic_load_explicit(&header->sequence, memory_order_relaxed);
+    atomic_store_explicit(&header->sequence, sequence + 1, memory_order_release);
+}
+
+const void *cstruct_ring_peek(cstruct_ring_t *ring, size_t *length)
+{
+    while (true)
+    {
+        size_t position = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+        __cstruct_ring_slot_t *slot = __cstruct_ring_slot_at(ring, position);
+
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (sequence != position + 1)
+        {
+            return NULL;
+        }
+
+        // NOTE(Caleb): Empty slots are left behind by producers whose packing failed
+        if (slot->length == 0)
+        {
+            cstruct_ring_release(ring);
+            continue;
+        }
+
+        if (length)
+        {
+            *length = slot->length;
+        }
+
+        return slot + 1;
+    }
+}
+
+void cstruct_ring_release(cstruct_ring_t *ring)
+{
+    size_t position = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    __cstruct_ring_slot_t *slot = __cstruct_ring_slot_at(ring, position);
+
+    atomic_store_explicit(&slot->sequence, position + ring->slot_count, memory_order_release);
+    atomic_store_explicit(&ring->tail, position + 1, memory_order_relaxed);
+}
+
+ssize_t cstruct_ring_pack(cstruct_ring_t *ring, const char *format, ...)
+{
+    void *slot = cstruct_ring_reserve(ring);
+    if (!slot)
+    {
+        return -1;
+    }
+
+    va_list args;
+    va_start(args, format);
+
+    ssize_t total_size = cstruct_vpack(format, slot, ring->slot_capacity, args);
+
+    va_end(args);
+
+    // NOTE(Caleb): The slot must be committed even if packing failed, or the consumer would stall
+    cstruct_ring_commit(ring, slot, total_size < 0 ? 0 : (size_t)total_size);
+
+    return total_size;
+}
+
+ssize_t cstruct_ring_unpack(cstruct_ring_t *ring, const char *format, ...)
+{
+    size_t      length = 0;
+    const void *slot   = cstruct_ring_peek(ring, &length);
+    if (!slot)
+    {
+        return 0;
+    }
+
+    va_list args;
+    va_start(args, format);
+
+    ssize_t bytes_read = cstruct_vunpack(format, slot, length, args);
+
+    va_end(args);
+
+    cstruct_ring_release(ring);
+
+    return bytes_read;
+}
+
+// Private Helpers ---------------------------------------------------------------------------------
+
+static inline size_t __cstruct_ring_slot_stride(size_t slot_capacity)
+{
+    if (slot_capacity > SIZE_MAX - sizeof(__cstruct_ring_slot_t) - CSTRUCT_RING_CACHE_LINE)
+    {
+        return 0;
+    }
+
+    size_t size = sizeof(__cstruct_ring_slot_t) + slot_capacity;
+    return (size + CSTRUCT_RING_CACHE_LINE - 1) / CSTRUCT_RING_CACHE_LINE * CSTRUCT_RING_CACHE_LINE;
+}
+
+static inline __cstruct_ring_slot_t *__cstruct_ring_slot_at(cstruct_ring_t *ring, size_t position)
+{
+    size_t index = position & (ring->slot_count - 1);
+    return (__cstruct_ring_slot_t *)(ring->slots + index * ring->slot_stride);
+}
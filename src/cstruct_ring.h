@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+// NOTE(Caleb): The size of a cache line. The hot indices of a ring, and each of its slots, start on
+// their own cache line so that producers and the consumer never contend over the same line.
+#define CSTRUCT_RING_CACHE_LINE 64
+
+/// The number of producers which may use a ring at once. There is only ever one consumer.
+typedef enum
+{
+    CSTRUCT_RING_SPSC, // Single producer, single consumer
+    CSTRUCT_RING_MPSC, // Multiple producers, single consumer
+} cstruct_ring_mode_t;
+
+/// A bounded, lock-free ring of fixed-size slots, each holding a single packed message.
+/// @note Producers reserve a slot, pack directly into it, and commit it. The consumer reads each
+///       committed slot in place, and then releases it back to the producers.
+typedef struct
+{
+    unsigned char      *slots;
+    size_t              slot_count;
+    size_t              slot_stride;
+    size_t              slot_capacity;
+    cstruct_ring_mode_t mode;
+
+    _Alignas(CSTRUCT_RING_CACHE_LINE) atomic_size_t head; // Next slot to reserve
+    _Alignas(CSTRUCT_RING_CACHE_LINE) atomic_size_t tail; // Next slot to consume
+} cstruct_ring_t;
+
+/// Return the size of the storage needed for a ring with the given number of slots.
+/// @param[in] slot_count The number of slots, which must be a power of two.
+/// @param[in] slot_capacity The maximum size of a single packed message.
+/// @return The size of the storage needed, in bytes, or 0 if it would overflow.
+size_t cstruct_ring_storage_size(size_t slot_count, size_t slot_capacity);
+
+/// Initialize a ring over caller-provided storage.
+/// @param[out] ring The ring to initialize.
+/// @param[in] storage The storage for the slots, which must be aligned to CSTRUCT_RING_CACHE_LINE.
+/// @param[in] storage_size The length of the storage. The ring uses the largest power of two number
+///                         of slots which fit.
+/// @param[in] slot_capacity The maximum size of a single packed message.
+/// @param[in] mode The number of producers which may use the ring at once.
+/// @return 0 on success, or -1 if an error occurred.
+int cstruct_ring_init(
+    cstruct_ring_t     *ring,
+    void               *storage,
+    size_t              storage_size,
+    size_t              slot_capacity,
+    cstruct_ring_mode_t mode);
+
+/// Reserve the next free slot of the ring.
+/// @param[inout] ring The ring.
+/// @return The slot, which may hold up to slot_capacity bytes, or NULL if the ring is full.
+/// @note Every reserved slot must be committed, in any order, before the consumer can move past it.
+void *cstruct_ring_reserve(cstruct_ring_t *ring);
+
+/// Publish a reserved slot to the consumer.
+/// @param[inout] ring The ring.
+/// @param[in] slot The slot, as returned by cstruct_ring_reserve.
+/// @param[in] length The number of bytes written to the slot, which must be no more than
+///                   slot_capacity. Empty slots are skipped by the consumer.
+void cstruct_ring_commit(cstruct_ring_t *ring, void *slot, size_t length);
+
+/// Return the oldest committed slot of the ring, without releasing it.
+/// @param[inout] ring The ring.
+/// @param[out] length The number of bytes held by the slot.
+/// @return The slot, or NULL if no committed slot is available.
+/// @note Only the consumer may call this function.
+const void *cstruct_ring_peek(cstruct_ring_t *ring, size_t *length);
+
+/// Release the slot returned by the last call to cstruct_ring_peek back to the producers.
+/// @param[inout] ring The ring.
+/// @note Only the consumer may call this function.
+void cstruct_ring_release(cstruct_ring_t *ring);
+
+/// Pack values directly into the next free slot of the ring, and commit it.
+/// @param[inout] ring The ring.
+/// @param[in] format The format string describing the data layout.
+/// @param[in] ... The values to pack, corresponding to the format string.
+/// @return The number of bytes packed, or -1 if the ring is full or an error occurred.
+ssize_t cstruct_ring_pack(cstruct_ring_t *ring, const char *format, ...);
+
+/// Unpack values directly from the oldest committed slot of the ring, and release it.
+/// @param[inout] ring The ring.
+/// @param[in] format The format string describing the data layout.
+/// @param[out] ... Pointers to variables where the unpacked values will be stored.
+/// @return The number of bytes unpacked, 0 if the ring is empty, or -1 if an error occurred.
+/// @note The slot is released even if an error occurred, so a bad message can't stall the ring.
+ssize_t cstruct_ring_unpack(cstruct_ring_t *ring, const char *format, ...);
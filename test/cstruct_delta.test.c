@@ -0,0 +1,140 @@
+#include "minunit.h"
+
+#include <stdint.h>
+
+#include "cstruct.h"
+
+#define STATE_FORMAT "!IHx3f4s"
+#define STATE_SIZE   23
+
+MU_TEST(test_unchanged_record)
+{
+    uint8_t previous[STATE_SIZE];
+    uint8_t delta[64];
+
+    cstruct_pack(STATE_FORMAT, previous, sizeof(previous), 7, 100, 1.0f, 2.0f, 3.0f, "abcd");
+
+    // NOTE(Caleb): Six fields (I, H, 3f, 4s) need a single byte of bitmask
+    ssize_t delta_size = cstruct_pack_delta(
+        STATE_FORMAT, previous, delta, sizeof(delta), 7, 100, 1.0f, 2.0f, 3.0f, "abcd");
+    mu_assert_int_eq(1, delta_size);
+    mu_assert_int_eq(0x00, delta[0]);
+
+    mu_assert_int_eq(1, cstruct_apply_delta(STATE_FORMAT, previous, sizeof(previous), delta, 1));
+}
+
+MU_TEST(test_changed_fields)
+{
+    uint8_t previous[STATE_SIZE];
+    uint8_t expected[STATE_SIZE];
+    uint8_t delta[64];
+
+    cstruct_pack(STATE_FORMAT, previous, sizeof(previous), 7, 100, 1.0f, 2.0f, 3.0f, "abcd");
+    cstruct_pack(STATE_FORMAT, expected, sizeof(expected), 8, 100, 1.0f, 2.5f, 3.0f, "abce");
+
+    ssize_t delta_size = cstruct_pack_delta(
+        STATE_FORMAT, previous, delta, sizeof(delta), 8, 100, 1.0f, 2.5f, 3.0f, "abce");
+    mu_assert_int_eq(1 + 4 + 4 + 4, delta_size);
+    mu_assert_int_eq(0x01 | 0x08 | 0x20, delta[0]);
+
+    ssize_t applied_size =
+        cstruct_apply_delta(STATE_FORMAT, previous, sizeof(previous), delta, delta_size);
+    mu_assert_int_eq(delta_size, applied_size);
+    mu_check(memcmp(previous, expected, STATE_SIZE) == 0);
+}
+
+MU_TEST(test_keyframe)
+{
+    uint8_t record[STATE_SIZE] = {0};
+    uint8_t expected[STATE_SIZE];
+    uint8_t delta[64];
+
+    cstruct_pack(STATE_FORMAT, expected, sizeof(expected), 1, 2, 3.0f, 4.0f, 5.0f, NULL);
+
+    // NOTE(Caleb): Without a previous record, every field is present
+    ssize_t delta_size =
+        cstruct_pack_delta(STATE_FORMAT, NULL, delta, sizeof(delta), 1, 2, 3.0f, 4.0f, 5.0f, NULL);
+    mu_assert_int_eq(1 + STATE_SIZE - 1, delta_size);
+    mu_assert_int_eq(0x3F, delta[0]);
+
+    mu_assert_int_eq(
+        delta_size, cstruct_apply_delta(STATE_FORMAT, record, sizeof(record), delta, delta_size));
+    mu_check(memcmp(record, expected, STATE_SIZE) == 0);
+}
+
+MU_TEST(test_groups)
+{
+    uint8_t previous[30];
+    uint8_t delta[64];
+
+    cstruct_pack(
+        "<3(Hff)", previous, sizeof(previous), 1, 0.0f, 0.0f, 2, 0.0f, 0.0f, 3, 0.0f, 0.0f);
+
+    // NOTE(Caleb): Nine fields need two bytes of bitmask, and only the last y changed
+    ssize_t delta_size = cstruct_pack_delta(
+        "<3(Hff)", previous, delta, sizeof(delta), 1, 0.0f, 0.0f, 2, 0.0f, 0.0f, 3, 0.0f, 9.0f);
+    mu_assert_int_eq(2 + 4, delta_size);
+    mu_assert_int_eq(0x00, delta[0]);
+    mu_assert_int_eq(0x01, delta[1]);
+
+    mu_assert_int_eq(
+        delta_size, cstruct_apply_delta("<3(Hff)", previous, sizeof(previous), delta, delta_size));
+
+    float y = 0;
+    memcpy(&y, previous + 26, 4);
+    mu_assert_double_eq(9.0, y);
+}
+
+MU_TEST(test_truncated_delta)
+{
+    uint8_t previous[STATE_SIZE];
+    uint8_t record[STATE_SIZE];
+    uint8_t delta[64];
+
+    cstruct_pack(STATE_FORMAT, previous, sizeof(previous), 7, 100, 1.0f, 2.0f, 3.0f, "abcd");
+    memcpy(record, previous, sizeof(record));
+
+    ssize_t delta_size = cstruct_pack_delta(
+        STATE_FORMAT, previous, delta, sizeof(delta), 8, 100, 1.0f, 2.5f, 3.0f, "abce");
+    mu_assert_int_eq(13, delta_size);
+
+    // NOTE(Caleb): Only the last field is missing, yet none of the others may be applied either
+    mu_assert_int_eq(
+        -1, cstruct_apply_delta(STATE_FORMAT, record, sizeof(record), delta, delta_size - 1));
+    mu_check(memcmp(record, previous, sizeof(record)) == 0);
+}
+
+MU_TEST(test_error_cases)
+{
+    uint8_t previous[STATE_SIZE] = {0};
+    uint8_t delta[64]            = {0};
+
+    mu_assert_int_eq(-1, cstruct_pack_delta("", previous, delta, sizeof(delta)));
+    mu_assert_int_eq(-1, cstruct_pack_delta("z", previous, delta, sizeof(delta), 0));
+    mu_assert_int_eq(-1, cstruct_pack_delta("!I", NULL, delta, 2, 1));
+
+    delta[0] = 0x01;
+
+    mu_assert_int_eq(-1, cstruct_apply_delta("z", previous, sizeof(previous), delta, 5));
+    mu_assert_int_eq(-1, cstruct_apply_delta("!I", previous, 3, delta, 5));
+    mu_assert_int_eq(-1, cstruct_apply_delta("!I", previous, sizeof(previous), delta, 0));
+    mu_assert_int_eq(-1, cstruct_apply_delta("!I", previous, sizeof(previous), delta, 4));
+}
+
+MU_TEST_SUITE(test_suite)
+{
+    MU_RUN_TEST(test_unchanged_record);
+    MU_RUN_TEST(test_changed_fields);
+    MU_RUN_TEST(test_keyframe);
+    MU_RUN_TEST(test_groups);
+    MU_RUN_TEST(test_truncated_delta);
+    MU_RUN_TEST(test_error_cases);
+}
+
+int main(void)
+{
+    MU_RUN_SUITE(test_suite);
+    MU_REPORT();
+
+    return MU_EXIT_CODE;
+}
@@ -0,0 +1,236 @@
+#include "minunit.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cstruct.h"
+#include "cstruct_dispatch.h"
+
+typedef struct
+{
+    uint16_t magic;
+    uint8_t  type;
+    uint32_t sequence_num;
+} header_t;
+
+#define HEADER_FORMAT "!HBxI"
+
+static const size_t header_offsets[] = {
+    offsetof(header_t, magic),
+    offsetof(header_t, type),
+    offsetof(header_t, sequence_num),
+};
+
+typedef struct
+{
+    float   position[3];
+    int16_t heading;
+} move_t;
+
+static const size_t move_offsets[] = {
+    offsetof(move_t, position[0]),
+    offsetof(move_t, position[1]),
+    offsetof(move_t, position[2]),
+    offsetof(move_t, heading),
+};
+
+typedef struct
+{
+    char     text[8];
+    uint64_t sender;
+} chat_t;
+
+static const size_t chat_offsets[] = {offsetof(chat_t, text), offsetof(chat_t, sender)};
+
+/// What the last handler saw.
+typedef struct
+{
+    int      calls;
+    header_t header;
+    move_t   move;
+    chat_t   chat;
+} seen_t;
+
+static void on_move(const void *header, const void *body, void *context)
+{
+    seen_t *seen = context;
+
+    seen->calls++;
+    memcpy(&seen->header, header, sizeof(seen->header));
+    memcpy(&seen->move, body, sizeof(seen->move));
+}
+
+static void on_chat(const void *header, const void *body, void *context)
+{
+    seen_t *seen = context;
+
+    seen->calls++;
+    memcpy(&seen->header, header, sizeof(seen->header));
+    memcpy(&seen->chat, body, sizeof(seen->chat));
+}
+
+static void on_ping(const void *header, const void *body, void *context)
+{
+    seen_t *seen = context;
+    (void)body;
+
+    seen->calls++;
+    memcpy(&seen->header, header, sizeof(seen->header));
+}
+
+MU_TEST(test_dense)
+{
+    seen_t              seen = {0};
+    cstruct_dispatch_t *dispatch =
+        cstruct_dispatch_create(HEADER_FORMAT, header_offsets, 3, sizeof(header_t), 1);
+    mu_check(dispatch != NULL);
+
+    mu_assert_int_eq(
+        0, cstruct_dispatch_register(
+               dispatch, 1, "3fh", move_offsets, 4, sizeof(move_t), on_move, &seen));
+    mu_assert_int_eq(
+        0, cstruct_dispatch_register(
+               dispatch, 2, "8sQ", chat_offsets, 2, sizeof(chat_t), on_chat, &seen));
+    mu_assert_int_eq(0, cstruct_dispatch_register(dispatch, 200, NULL, NULL, 0, 0, on_ping, &seen));
+
+    _Alignas(max_align_t) uint8_t storage[64];
+    mu_check(cstruct_dispatch_storage_size(dispatch) <= sizeof(storage));
+
+    uint8_t buffer[64] = {0};
+    ssize_t size       = cstruct_pack(
+        "!HBxI3fh", buffer, sizeof(buffer), 0xCAFE, 1, 7, 1.0f, -2.0f, 0.5f, -90);
+    mu_assert_int_eq(22, size);
+
+    mu_assert_int_eq(size, cstruct_dispatch(dispatch, buffer, size, storage, sizeof(storage)));
+    mu_assert_int_eq(1, seen.calls);
+    mu_assert_int_eq(0xCAFE, seen.header.magic);
+    mu_assert_int_eq(7, seen.header.sequence_num);
+    mu_assert_double_eq(-2.0, seen.move.position[1]);
+    mu_assert_int_eq(-90, seen.move.heading);
+
+    char text[8] = "hello";
+    size         = cstruct_pack("!HBxI8sQ", buffer, sizeof(buffer), 0xCAFE, 2, 8, text, 42ULL);
+    mu_assert_int_eq(size, cstruct_dispatch(dispatch, buffer, size, storage, sizeof(storage)));
+    mu_assert_int_eq(2, seen.calls);
+    mu_assert_int_eq(8, seen.header.sequence_num);
+    mu_check(strcmp(seen.chat.text, "hello") == 0);
+    mu_assert_int_eq(42, (int)seen.chat.sender);
+
+    size = cstruct_pack("!HBxI", buffer, sizeof(buffer), 0xCAFE, 200, 9);
+    mu_assert_int_eq(size, cstruct_dispatch(dispatch, buffer, size, storage, sizeof(storage)));
+    mu_assert_int_eq(3, seen.calls);
+    mu_assert_int_eq(200, seen.header.type);
+
+    // NOTE(Caleb): Unregistered types, and types next to registered ones, reach no handler
+    cstruct_pack("!HBxI", buffer, sizeof(buffer), 0xCAFE, 3, 10);
+    mu_assert_int_eq(-1, cstruct_dispatch(dispatch, buffer, 8, storage, sizeof(storage)));
+    cstruct_pack("!HBxI", buffer, sizeof(buffer), 0xCAFE, 0, 10);
+    mu_assert_int_eq(-1, cstruct_dispatch(dispatch, buffer, 8, storage, sizeof(storage)));
+    mu_assert_int_eq(3, seen.calls);
+
+    cstruct_dispatch_free(dispatch);
+}
+
+MU_TEST(test_hashed)
+{
+    typedef struct
+    {
+        int32_t  type;
+        uint16_t length;
+    } wide_header_t;
+
+    static const size_t wide_offsets[] = {
+        offsetof(wide_header_t, type), offsetof(wide_header_t, length)};
+    static const int64_t types[] = {
+        7, -1, 0x1000, 0x7FFFFFFF, 123456789, -2000000000, 42, 0x00BEEF00, -77, 65536,
+    };
+    static const size_t type_count = sizeof(types) / sizeof(types[0]);
+
+    seen_t              seen[sizeof(types) / sizeof(types[0])] = {0};
+    cstruct_dispatch_t *dispatch =
+        cstruct_dispatch_create("<iH", wide_offsets, 2, sizeof(wide_header_t), 0);
+    mu_check(dispatch != NULL);
+
+    for (size_t i = 0; i < type_count; i++)
+    {
+        mu_assert_int_eq(
+            0, cstruct_dispatch_register(
+                   dispatch, (uint64_t)types[i], NULL, NULL, 0, 0, on_ping, &seen[i]));
+    }
+
+    mu_assert_int_eq(
+        -1, cstruct_dispatch_register(dispatch, 42, NULL, NULL, 0, 0, on_ping, &seen[0]));
+
+    _Alignas(max_align_t) uint8_t storage[64];
+    uint8_t                       buffer[8];
+
+    for (size_t i = 0; i < type_count; i++)
+    {
+        cstruct_pack("<iH", buffer, sizeof(buffer), (int32_t)types[i], (uint16_t)i);
+        mu_assert_int_eq(6, cstruct_dispatch(dispatch, buffer, 6, storage, sizeof(storage)));
+    }
+
+    for (size_t i = 0; i < type_count; i++)
+    {
+        mu_assert_int_eq(1, seen[i].calls);
+        mu_assert_int_eq(i, ((wide_header_t *)&seen[i].header)->length);
+    }
+
+    cstruct_pack("<iH", buffer, sizeof(buffer), 8, 0);
+    mu_assert_int_eq(-1, cstruct_dispatch(dispatch, buffer, 6, storage, sizeof(storage)));
+
+    cstruct_dispatch_free(dispatch);
+}
+
+MU_TEST(test_error_cases)
+{
+    seen_t  seen = {0};
+    uint8_t storage[64];
+    uint8_t buffer[64] = {0};
+
+    // NOTE(Caleb): The discriminator must exist, and be an integer
+    mu_check(!cstruct_dispatch_create(HEADER_FORMAT, header_offsets, 3, sizeof(header_t), 3));
+    mu_check(!cstruct_dispatch_create("!H2sI", header_offsets, 3, sizeof(header_t), 1));
+    mu_check(!cstruct_dispatch_create(HEADER_FORMAT, header_offsets, 2, sizeof(header_t), 1));
+    mu_check(!cstruct_dispatch_create("!HBxIz", header_offsets, 3, sizeof(header_t), 1));
+    mu_check(!cstruct_dispatch_create(HEADER_FORMAT, NULL, 3, sizeof(header_t), 1));
+
+    cstruct_dispatch_t *dispatch =
+        cstruct_dispatch_create(HEADER_FORMAT, header_offsets, 3, sizeof(header_t), 1);
+
+    // NOTE(Caleb): Bodies can't set their own byte order, and need one offset per value
+    mu_assert_int_eq(
+        -1, cstruct_dispatch_register(
+                dispatch, 1, "<3fh", move_offsets, 4, sizeof(move_t), on_move, &seen));
+    mu_assert_int_eq(
+        -1, cstruct_dispatch_register(
+                dispatch, 1, "3fh", move_offsets, 3, sizeof(move_t), on_move, &seen));
+    mu_assert_int_eq(
+        0, cstruct_dispatch_register(
+               dispatch, 1, "3fh", move_offsets, 4, sizeof(move_t), on_move, &seen));
+
+    ssize_t size = cstruct_pack(
+        "!HBxI3fh", buffer, sizeof(buffer), 0xCAFE, 1, 7, 1.0f, -2.0f, 0.5f, -90);
+
+    mu_assert_int_eq(-1, cstruct_dispatch(dispatch, buffer, 2, storage, sizeof(storage)));
+    mu_assert_int_eq(-1, cstruct_dispatch(dispatch, buffer, size - 1, storage, sizeof(storage)));
+    mu_assert_int_eq(-1, cstruct_dispatch(dispatch, buffer, size, storage, 8));
+    mu_assert_int_eq(0, seen.calls);
+
+    cstruct_dispatch_free(dispatch);
+}
+
+MU_TEST_SUITE(test_suite)
+{
+    MU_RUN_TEST(test_dense);
+    MU_RUN_TEST(test_hashed);
+    MU_RUN_TEST(test_error_cases);
+}
+
+int main(void)
+{
+    MU_RUN_SUITE(test_suite);
+    MU_REPORT();
+
+    return MU_EXIT_CODE;
+}
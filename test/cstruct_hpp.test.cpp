@@ -0,0 +1,253 @@
+#include "minunit.h"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+
+#include "cstruct.h"
+#include "cstruct.hpp"
+
+// NOTE(Caleb): The game packet header from the example, without its reserved byte, which is padding
+struct packet_header
+{
+    uint16_t magic;
+    uint8_t  version;
+    uint8_t  packet_type;
+    uint32_t sequence_num;
+    uint32_t timestamp;
+    uint16_t payload_length;
+    uint8_t  flags;
+    char     session_id[16];
+    float    position[3];
+    int16_t  rotation[3];
+    uint8_t  health;
+    uint8_t  checksum;
+};
+
+#define PACKET_HEADER_FORMAT "!HBBIIHBx16s3f3hBB"
+
+static_assert(cstruct::size_of<"!HBBIIHBx16s3f3hBB"> == 52);
+static_assert(cstruct::size_of<"<2(B3(H)x)"> == 16);
+static_assert(cstruct::size_of<"10s"> == 10);
+
+MU_TEST(test_round_trip)
+{
+    std::array<uint8_t, 64> buffer {};
+
+    std::ptrdiff_t packed_size =
+        cstruct::pack<"!bHiQfd3s">(buffer, -5, 0xBEEF, -70000, 42ULL, 1.5f, -0.25, "abc");
+    mu_assert_int_eq(30, packed_size);
+
+    const uint8_t expected_prefix[] = {0xFB, 0xBE, 0xEF, 0xFF, 0xFE, 0xEE, 0x90};
+    mu_check(memcmp(buffer.data(), expected_prefix, sizeof(expected_prefix)) == 0);
+
+    int8_t   b = 0;
+    uint16_t h = 0;
+    int32_t  i = 0;
+    uint64_t q = 0;
+    float    f = 0;
+    double   d = 0;
+    char     s[3];
+
+    std::ptrdiff_t unpacked_size = cstruct::unpack<"!bHiQfd3s">(
+        std::span<const uint8_t>(buffer.data(), packed_size), b, h, i, q, f, d, s);
+    mu_assert_int_eq(30, unpacked_size);
+    mu_assert_int_eq(-5, b);
+    mu_assert_int_eq(0xBEEF, h);
+    mu_assert_int_eq(-70000, i);
+    mu_assert_int_eq(42, (int)q);
+    mu_assert_double_eq(1.5, f);
+    mu_assert_double_eq(-0.25, d);
+    mu_check(memcmp(s, "abc", 3) == 0);
+}
+
+MU_TEST(test_matches_c)
+{
+    uint8_t c_buffer[64]  = {0};
+    uint8_t cc_buffer[64] = {0};
+
+    ssize_t c_size = cstruct_pack(
+        "<2(B3(H)x)q2s", c_buffer, sizeof(c_buffer), 1, 2, 3, 4, 5, 6, 7, 8, -9LL, "hi");
+    std::ptrdiff_t cc_size =
+        cstruct::pack<"<2(B3(H)x)q2s">(cc_buffer, 1, 2, 3, 4, 5, 6, 7, 8, -9LL, "hi");
+
+    mu_assert_int_eq(26, c_size);
+    mu_assert_int_eq(c_size, cc_size);
+    mu_check(memcmp(c_buffer, cc_buffer, sizeof(c_buffer)) == 0);
+}
+
+MU_TEST(test_unpack_tuple)
+{
+    std::array<uint8_t, 16> buffer {};
+    cstruct::pack<">Hd4s">(buffer, 0x1234, 2.5, std::string_view("ab"));
+
+    auto values = cstruct::unpack<">Hd4s">(std::span<const uint8_t>(buffer));
+    mu_check(values.has_value());
+
+    auto [h, d, s] = *values;
+    mu_assert_int_eq(0x1234, h);
+    mu_assert_double_eq(2.5, d);
+    mu_check(s == (std::array<char, 4> {'a', 'b', '\0', '\0'}));
+
+    mu_check(!cstruct::unpack<">Hd4s">(std::span<const uint8_t>(buffer.data(), 13)).has_value());
+}
+
+MU_TEST(test_struct_matches_c)
+{
+    packet_header header = {
+        0xCAFE, 1, 2, 1000, 123456, 64, 0x80, "session-0123456", {1.0f, 2.0f, 3.0f},
+        {-1, 0, 1}, 100, 0x5A,
+    };
+
+    uint8_t c_buffer[64]  = {0};
+    uint8_t cc_buffer[64] = {0};
+
+    ssize_t c_size = cstruct_pack(
+        PACKET_HEADER_FORMAT, c_buffer, sizeof(c_buffer), header.magic, header.version,
+        header.packet_type, header.sequence_num, header.timestamp, header.payload_length,
+        header.flags, header.session_id, header.position[0], header.position[1],
+        header.position[2], header.rotation[0], header.rotation[1], header.rotation[2],
+        header.health, header.checksum);
+    std::ptrdiff_t cc_size = cstruct::pack_struct<PACKET_HEADER_FORMAT>(cc_buffer, header);
+
+    mu_assert_int_eq(52, c_size);
+    mu_assert_int_eq(c_size, cc_size);
+    mu_check(memcmp(c_buffer, cc_buffer, sizeof(c_buffer)) == 0);
+
+    packet_header  unpacked      = {};
+    std::ptrdiff_t unpacked_size = cstruct::unpack_struct<PACKET_HEADER_FORMAT>(
+        std::span<const uint8_t>(c_buffer), unpacked);
+    mu_assert_int_eq(52, unpacked_size);
+    mu_assert_int_eq(header.magic, unpacked.magic);
+    mu_assert_int_eq(header.sequence_num, unpacked.sequence_num);
+    mu_assert_double_eq(header.position[2], unpacked.position[2]);
+    mu_assert_int_eq(header.rotation[0], unpacked.rotation[0]);
+    mu_assert_int_eq(header.checksum, unpacked.checksum);
+    mu_check(memcmp(header.session_id, unpacked.session_id, 16) == 0);
+}
+
+MU_TEST(test_tuple_struct)
+{
+    std::array<uint8_t, 8> buffer {};
+
+    std::tuple<uint16_t, int32_t> values {0xBEEF, -2};
+    mu_assert_int_eq(6, cstruct::pack_struct<"!Hi">(buffer, values));
+
+    std::tuple<uint16_t, int32_t> unpacked {};
+    mu_assert_int_eq(6, cstruct::unpack_struct<"!Hi">(std::span<const uint8_t>(buffer), unpacked));
+    mu_check(values == unpacked);
+}
+
+MU_TEST(test_native)
+{
+    struct native_t
+    {
+        uint8_t  a;
+        uint32_t b;
+        char     name[3];
+        int16_t  c[2];
+        double   d;
+    };
+
+    static_assert(cstruct::size_of<"@BI3s2hd"> == sizeof(native_t));
+    static_assert(cstruct::size_of<"@B2(BH)d"> == 24);
+    static_assert(cstruct::size_of<"=BI3s2hd"> == 20);
+    static_assert(cstruct::size_of<"@l"> == sizeof(long));
+
+    // NOTE(Caleb): Mark the padding, which must not reach the packed blob even though the struct is
+    // copied with a single memcpy
+    native_t native;
+    memset(&native, 0xAA, sizeof(native));
+
+    native.a = 7;
+    native.b = 0xDEADBEEF;
+    native.d = 0.5;
+    memcpy(native.name, "abc", 3);
+    native.c[0] = 1;
+    native.c[1] = -3;
+
+    uint8_t c_buffer[64]  = {0};
+    uint8_t cc_buffer[64] = {0};
+
+    ssize_t c_size = cstruct_pack(
+        "@BI3s2hd", c_buffer, sizeof(c_buffer), native.a, native.b, native.name, native.c[0],
+        native.c[1], native.d);
+    std::ptrdiff_t cc_size = cstruct::pack_struct<"@BI3s2hd">(cc_buffer, native);
+
+    // NOTE(Caleb): Padding is packed as zeroes, even though the struct's own padding isn't zero
+    mu_assert_int_eq(c_size, cc_size);
+    mu_assert_int_eq(0x00, cc_buffer[1]);
+    mu_check(memcmp(c_buffer, cc_buffer, sizeof(c_buffer)) == 0);
+
+    native_t unpacked = {};
+    cstruct::unpack_struct<"@BI3s2hd">(std::span<const uint8_t>(c_buffer), unpacked);
+    mu_assert_int_eq(native.a, unpacked.a);
+    mu_check(unpacked.b == native.b);
+    mu_check(memcmp(native.name, unpacked.name, 3) == 0);
+    mu_assert_int_eq(native.c[0], unpacked.c[0]);
+    mu_assert_int_eq(native.c[1], unpacked.c[1]);
+    mu_assert_double_eq(native.d, unpacked.d);
+
+    // NOTE(Caleb): The same groups as cstruct.c, with the same padding
+    mu_assert_int_eq(
+        cstruct_pack("@B2(BH)d", c_buffer, sizeof(c_buffer), 1, 2, 3, 4, 5, 6.0),
+        cstruct::pack<"@B2(BH)d">(cc_buffer, 1, 2, 3, 4, 5, 6.0));
+    mu_check(memcmp(c_buffer, cc_buffer, 24) == 0);
+}
+
+MU_TEST(test_key)
+{
+    uint8_t c_buffer[32]  = {0};
+    uint8_t cc_buffer[32] = {0};
+
+    ssize_t c_size = cstruct_pack(
+        "^bHiqfd", c_buffer, sizeof(c_buffer), -3, 0xBEEF, -70000, 5LL, -1.5f, 0.25);
+    std::ptrdiff_t cc_size =
+        cstruct::pack<"^bHiqfd">(cc_buffer, -3, 0xBEEF, -70000, 5LL, -1.5f, 0.25);
+
+    mu_assert_int_eq(27, c_size);
+    mu_assert_int_eq(c_size, cc_size);
+    mu_check(memcmp(c_buffer, cc_buffer, sizeof(c_buffer)) == 0);
+
+    auto values = cstruct::unpack<"^bHiqfd">(std::span<const uint8_t>(c_buffer));
+    mu_check(values.has_value());
+
+    auto [b, h, i, q, f, d] = *values;
+    mu_assert_int_eq(-3, b);
+    mu_assert_int_eq(0xBEEF, h);
+    mu_assert_int_eq(-70000, i);
+    mu_assert_int_eq(5, (int)q);
+    mu_assert_double_eq(-1.5, f);
+    mu_assert_double_eq(0.25, d);
+}
+
+MU_TEST(test_error_cases)
+{
+    std::array<uint8_t, 8> buffer {};
+
+    mu_assert_int_eq(-1, cstruct::pack<"3I">(buffer, 1, 2, 3));
+
+    uint16_t h = 0;
+    mu_assert_int_eq(-1, cstruct::unpack<"!2H">(std::span<const uint8_t>(buffer.data(), 3), h, h));
+}
+
+MU_TEST_SUITE(test_suite)
+{
+    MU_RUN_TEST(test_round_trip);
+    MU_RUN_TEST(test_matches_c);
+    MU_RUN_TEST(test_unpack_tuple);
+    MU_RUN_TEST(test_struct_matches_c);
+    MU_RUN_TEST(test_tuple_struct);
+    MU_RUN_TEST(test_native);
+    MU_RUN_TEST(test_key);
+    MU_RUN_TEST(test_error_cases);
+}
+
+int main(void)
+{
+    MU_RUN_SUITE(test_suite);
+    MU_REPORT();
+
+    return MU_EXIT_CODE;
+}
@@ -0,0 +1,259 @@
+#include "minunit.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "cstruct_io.h"
+
+#define RECORD_FORMAT "!IhdB"
+
+enum
+{
+    RECORD_SIZE  = 15,
+    RECORD_COUNT = 5000,
+};
+
+/// Find the most recently opened io_uring instance of this process.
+/// @return Its file descriptor, or -1 if there is none.
+static int find_uring_fd(void)
+{
+    DIR *dir = opendir("/proc/self/fd");
+    if (!dir)
+    {
+        return -1;
+    }
+
+    int            found = -1;
+    struct dirent *entry = NULL;
+    while ((entry = readdir(dir)))
+    {
+        char path[sizeof("/proc/self/fd/") + sizeof(entry->d_name)];
+        char target[64] = {0};
+        snprintf(path, sizeof(path), "/proc/self/fd/%s", entry->d_name);
+
+        if (readlink(path, target, sizeof(target) - 1) > 0
+            && strcmp(target, "anon_inode:[io_uring]") == 0 && atoi(entry->d_name) > found)
+        {
+            found = atoi(entry->d_name);
+        }
+    }
+
+    closedir(dir);
+    return found;
+}
+
+MU_TEST(test_round_trip)
+{
+    FILE *file = tmpfile();
+    mu_check(file != NULL);
+
+    // NOTE(Caleb): A small buffer forces many batches, and records which straddle both buffers
+    cstruct_writer_t *writer = cstruct_writer_open(fileno(file), 0, 64);
+    mu_check(writer != NULL);
+
+    for (int i = 0; i < RECORD_COUNT; i++)
+    {
+        mu_assert_int_eq(
+            RECORD_SIZE, cstruct_writer_pack(writer, RECORD_FORMAT, i, -i, i * 0.5, i & 0xFF));
+    }
+
+    mu_assert_int_eq(0, cstruct_writer_close(writer));
+
+    fseek(file, 0, SEEK_END);
+    mu_assert_int_eq(RECORD_SIZE * RECORD_COUNT, ftell(file));
+
+    cstruct_reader_t *reader = cstruct_reader_open(fileno(file), 0, 64);
+    mu_check(reader != NULL);
+
+    int mismatches = 0;
+    for (int i = 0; i < RECORD_COUNT; i++)
+    {
+        uint32_t u = 0;
+        int16_t  h = 0;
+        double   d = 0;
+        uint8_t  b = 0;
+
+        mu_assert_int_eq(RECORD_SIZE, cstruct_reader_unpack(reader, RECORD_FORMAT, &u, &h, &d, &b));
+        mismatches += u != (uint32_t)i || h != -i || d != i * 0.5 || b != (i & 0xFF);
+    }
+
+    mu_assert_int_eq(0, mismatches);
+
+    uint32_t u = 0;
+    int16_t  h = 0;
+    double   d = 0;
+    uint8_t  b = 0;
+    mu_assert_int_eq(0, cstruct_reader_unpack(reader, RECORD_FORMAT, &u, &h, &d, &b));
+
+    cstruct_reader_close(reader);
+    fclose(file);
+}
+
+MU_TEST(test_offset_and_flush)
+{
+    FILE *file = tmpfile();
+    mu_check(file != NULL);
+
+    cstruct_writer_t *writer = cstruct_writer_open(fileno(file), 4, 4096);
+    mu_check(writer != NULL);
+
+    mu_assert_int_eq(2, cstruct_writer_pack(writer, "!H", 0xABCD));
+    mu_assert_int_eq(0, cstruct_writer_flush(writer));
+    mu_assert_int_eq(2, cstruct_writer_pack(writer, "<H", 0xABCD));
+    mu_assert_int_eq(0, cstruct_writer_close(writer));
+
+    uint8_t contents[8] = {0};
+    fseek(file, 0, SEEK_SET);
+    mu_assert_int_eq(8, fread(contents, 1, sizeof(contents), file));
+
+    const uint8_t expected[] = {0x00, 0x00, 0x00, 0x00, 0xAB, 0xCD, 0xCD, 0xAB};
+    mu_check(memcmp(contents, expected, sizeof(expected)) == 0);
+
+    cstruct_reader_t *reader = cstruct_reader_open(fileno(file), 4, 4096);
+    mu_check(reader != NULL);
+
+    uint16_t h = 0;
+    mu_assert_int_eq(2, cstruct_reader_unpack(reader, "!H", &h));
+    mu_assert_int_eq(0xABCD, h);
+
+    // NOTE(Caleb): A record cut short by the end of the file is an error
+    mu_assert_int_eq(-1, cstruct_reader_unpack(reader, "!I", &h));
+
+    cstruct_reader_close(reader);
+    fclose(file);
+}
+
+MU_TEST(test_failed_submit)
+{
+    FILE *file = tmpfile();
+    mu_check(file != NULL);
+
+    int null_fd = open("/dev/null", O_RDWR);
+    mu_check(null_fd >= 0);
+
+    // NOTE(Caleb): While the io_uring instance is swapped for /dev/null, every submission fails and
+    // the writer falls back to pwritev. Once the instance is back, no entry left over from a failed
+    // submission may be picked up, since its buffer has been written and reused since.
+    cstruct_writer_t *writer   = cstruct_writer_open(fileno(file), 0, 64);
+    int               uring_fd = find_uring_fd();
+    int               saved_fd = uring_fd >= 0 ? dup(uring_fd) : -1;
+    mu_check(writer != NULL);
+
+    for (int i = 0; i < RECORD_COUNT; i++)
+    {
+        if (uring_fd >= 0 && i == 0)
+        {
+            dup2(null_fd, uring_fd);
+        }
+        else if (uring_fd >= 0 && i == 6)
+        {
+            dup2(saved_fd, uring_fd);
+        }
+
+        mu_assert_int_eq(
+            RECORD_SIZE, cstruct_writer_pack(writer, RECORD_FORMAT, i, -i, i * 0.5, i & 0xFF));
+    }
+
+    mu_assert_int_eq(0, cstruct_writer_close(writer));
+
+    if (saved_fd >= 0)
+    {
+        close(saved_fd);
+    }
+
+    // NOTE(Caleb): The same again for the reader, which falls back to pread
+    cstruct_reader_t *reader = cstruct_reader_open(fileno(file), 0, 64);
+    uring_fd                 = find_uring_fd();
+    saved_fd                 = uring_fd >= 0 ? dup(uring_fd) : -1;
+    mu_check(reader != NULL);
+
+    int mismatches = 0;
+    for (int i = 0; i < RECORD_COUNT; i++)
+    {
+        if (uring_fd >= 0 && i == 0)
+        {
+            dup2(null_fd, uring_fd);
+        }
+        else if (uring_fd >= 0 && i == 6)
+        {
+            dup2(saved_fd, uring_fd);
+        }
+
+        uint32_t u = 0;
+        int16_t  h = 0;
+        double   d = 0;
+        uint8_t  b = 0;
+
+        mu_assert_int_eq(RECORD_SIZE, cstruct_reader_unpack(reader, RECORD_FORMAT, &u, &h, &d, &b));
+        mismatches += u != (uint32_t)i || h != -i || d != i * 0.5 || b != (i & 0xFF);
+    }
+
+    mu_assert_int_eq(0, mismatches);
+    cstruct_reader_close(reader);
+
+    if (saved_fd >= 0)
+    {
+        close(saved_fd);
+    }
+
+    close(null_fd);
+    fclose(file);
+}
+
+MU_TEST(test_error_cases)
+{
+    mu_check(cstruct_writer_open(-1, 0, 64) == NULL);
+    mu_check(cstruct_writer_open(0, 0, 0) == NULL);
+    mu_check(cstruct_reader_open(-1, 0, 64) == NULL);
+    mu_check(cstruct_reader_open(0, 0, 0) == NULL);
+
+    // NOTE(Caleb): io_uring can't write or read 2 GiB or more at once
+    mu_check(cstruct_writer_open(0, 0, (size_t)INT32_MAX + 1) == NULL);
+    mu_check(cstruct_reader_open(0, 0, (size_t)INT32_MAX + 1) == NULL);
+
+    FILE *file = tmpfile();
+    mu_check(file != NULL);
+
+    cstruct_writer_t *writer = cstruct_writer_open(fileno(file), 0, 8);
+    mu_assert_int_eq(-1, cstruct_writer_pack(writer, "!3I", 1, 2, 3));
+    mu_assert_int_eq(-1, cstruct_writer_pack(writer, "z", 1));
+
+    // NOTE(Caleb): A record which fails for any reason but space doesn't flush the current buffer
+    mu_assert_int_eq(2, cstruct_writer_pack(writer, "!H", 0xABCD));
+    mu_assert_int_eq(-1, cstruct_writer_pack(writer, "!Hz", 1, 2));
+    fseek(file, 0, SEEK_END);
+    mu_assert_int_eq(0, ftell(file));
+
+    mu_assert_int_eq(0, cstruct_writer_close(writer));
+    fseek(file, 0, SEEK_END);
+    mu_assert_int_eq(2, ftell(file));
+
+    cstruct_reader_t *reader = cstruct_reader_open(fileno(file), 0, 8);
+    uint32_t          u      = 0;
+    mu_assert_int_eq(-1, cstruct_reader_unpack(reader, "!3I", &u, &u, &u));
+    mu_assert_int_eq(2, cstruct_reader_unpack(reader, "!H", &u));
+    mu_assert_int_eq(0, cstruct_reader_unpack(reader, "!I", &u));
+    cstruct_reader_close(reader);
+
+    fclose(file);
+}
+
+MU_TEST_SUITE(test_suite)
+{
+    MU_RUN_TEST(test_round_trip);
+    MU_RUN_TEST(test_offset_and_flush);
+    MU_RUN_TEST(test_failed_submit);
+    MU_RUN_TEST(test_error_cases);
+}
+
+int main(void)
+{
+    MU_RUN_SUITE(test_suite);
+    MU_REPORT();
+
+    return MU_EXIT_CODE;
+}
@@ -0,0 +1,268 @@
+#include "minunit.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cstruct.h"
+#include "cstruct_jit.h"
+
+// NOTE(Caleb): Members are deliberately out of format order, to exercise the offset table
+typedef struct
+{
+    double   d;
+    char     name[5];
+    int8_t   b;
+    uint16_t h[3];
+    float    f;
+    uint64_t q;
+    int32_t  i;
+} record_t;
+
+#define RECORD_FORMAT "!bHx2(H)2xiQ5sfd"
+
+static const size_t record_offsets[] = {
+    offsetof(record_t, b),
+    offsetof(record_t, h[0]),
+    offsetof(record_t, h[1]),
+    offsetof(record_t, h[2]),
+    offsetof(record_t, i),
+    offsetof(record_t, q),
+    offsetof(record_t, name),
+    offsetof(record_t, f),
+    offsetof(record_t, d),
+};
+
+#define RECORD_OFFSET_COUNT (sizeof(record_offsets) / sizeof(record_offsets[0]))
+
+static const record_t record = {
+    -0.125, {'c', 's', 't', 'r', 't'}, -7, {0x0102, 0x0304, 0x0506}, 2.5f, 0x1122334455667788ULL,
+    -123456,
+};
+
+MU_TEST(test_matches_interpreter)
+{
+    static const char *formats[] = {RECORD_FORMAT, "<bHx2(H)2xiQ5sfd", ">bHx2(H)2xiQ5sfd"};
+
+    for (size_t k = 0; k < sizeof(formats) / sizeof(formats[0]); k++)
+    {
+        uint8_t expected[64] = {0};
+        uint8_t actual[64];
+
+        memset(actual, 0xAA, sizeof(actual));
+
+        ssize_t expected_size = cstruct_pack(
+            formats[k], expected, sizeof(expected), record.b, record.h[0], record.h[1],
+            record.h[2], record.i, record.q, record.name, record.f, record.d);
+        mu_assert_int_eq(39, expected_size);
+
+        cstruct_jit_t *jit = cstruct_jit_compile(formats[k], record_offsets, RECORD_OFFSET_COUNT);
+        mu_check(jit != NULL);
+
+        mu_assert_int_eq(39, cstruct_jit_pack(jit, actual, sizeof(actual), &record));
+        mu_check(memcmp(expected, actual, 39) == 0);
+
+        record_t unpacked;
+        memset(&unpacked, 0, sizeof(unpacked));
+
+        mu_assert_int_eq(39, cstruct_jit_unpack(jit, actual, 39, &unpacked));
+        mu_check(memcmp(&record, &unpacked, sizeof(record)) == 0);
+
+        cstruct_jit_free(jit);
+    }
+}
+
+MU_TEST(test_struct_interpreter)
+{
+    uint8_t expected[64] = {0};
+    uint8_t actual[64]   = {0};
+
+    cstruct_pack(
+        RECORD_FORMAT, expected, sizeof(expected), record.b, record.h[0], record.h[1], record.h[2],
+        record.i, record.q, record.name, record.f, record.d);
+
+    mu_assert_int_eq(
+        39, cstruct_pack_struct(
+                RECORD_FORMAT, actual, sizeof(actual), &record, record_offsets,
+                RECORD_OFFSET_COUNT));
+    mu_check(memcmp(expected, actual, sizeof(actual)) == 0);
+
+    record_t unpacked;
+    memset(&unpacked, 0, sizeof(unpacked));
+
+    mu_assert_int_eq(
+        39, cstruct_unpack_struct(
+                RECORD_FORMAT, actual, 39, &unpacked, record_offsets, RECORD_OFFSET_COUNT));
+    mu_check(memcmp(&record, &unpacked, sizeof(record)) == 0);
+}
+
+MU_TEST(test_fields)
+{
+    cstruct_field_t fields[8];
+
+    mu_assert_int_eq(6, cstruct_fields("<B2(H)3x4sd", fields, 8));
+    mu_assert_int_eq('B', fields[0].format_char);
+    mu_assert_int_eq(3, fields[2].offset);
+    mu_assert_int_eq('x', fields[3].format_char);
+    mu_assert_int_eq(3, fields[3].size);
+    mu_assert_int_eq(8, fields[4].offset);
+    mu_assert_int_eq(4, fields[4].size);
+    mu_assert_int_eq(12, fields[5].offset);
+
+    mu_assert_int_eq(6, cstruct_fields("<B2(H)3x4sd", NULL, 0));
+    mu_assert_int_eq(-1, cstruct_fields("2(H", NULL, 0));
+}
+
+MU_TEST(test_overlay)
+{
+    typedef struct
+    {
+        double   d;
+        uint32_t b;
+        int16_t  c[2];
+        char     name[8];
+    } native_t;
+
+    static const size_t native_offsets[] = {
+        offsetof(native_t, d),    offsetof(native_t, b),    offsetof(native_t, c[0]),
+        offsetof(native_t, c[1]), offsetof(native_t, name),
+    };
+
+    mu_check(cstruct_is_overlay("@dI2h8s", native_offsets, 5, sizeof(native_t)));
+
+    // NOTE(Caleb): Byte order, offsets, or size which differ from the struct rule out an overlay
+    mu_check(!cstruct_is_overlay("!dI2h8s", native_offsets, 5, sizeof(native_t)));
+    mu_check(!cstruct_is_overlay("@dI2h8s", native_offsets, 4, sizeof(native_t)));
+    mu_check(!cstruct_is_overlay("@dI2h8s", native_offsets, 5, sizeof(native_t) - 8));
+    mu_check(!cstruct_is_overlay("@dI2h8sz", native_offsets, 5, sizeof(native_t)));
+
+    native_t native = {0};
+    native.d        = 0.5;
+    native.b        = 0xDEADBEEF;
+    native.c[1]     = -3;
+    memcpy(native.name, "abcdefg", 8);
+
+    uint8_t expected[64] = {0};
+    uint8_t actual[64]   = {0};
+
+    ssize_t size = cstruct_pack(
+        "@dI2h8s", expected, sizeof(expected), native.d, native.b, native.c[0], native.c[1],
+        native.name);
+
+    cstruct_jit_t *jit = cstruct_jit_compile("@dI2h8s", native_offsets, 5);
+    mu_check(cstruct_jit_is_native(jit));
+
+    mu_assert_int_eq(size, cstruct_jit_pack(jit, actual, sizeof(actual), &native));
+    mu_check(memcmp(expected, actual, sizeof(actual)) == 0);
+
+    native_t unpacked = {0};
+    mu_assert_int_eq(size, cstruct_jit_unpack(jit, actual, size, &unpacked));
+    mu_check(memcmp(&native, &unpacked, sizeof(native)) == 0);
+
+    cstruct_jit_free(jit);
+}
+
+MU_TEST(test_overlay_padding)
+{
+    typedef struct
+    {
+        uint8_t  a;
+        uint8_t  b;
+        uint16_t c;
+    } gap_t;
+
+    // NOTE(Caleb): The explicit padding lies over b, which the format string doesn't map, so the
+    // overlay must pack it as zero, and leave it alone when unpacking
+    static const size_t gap_offsets[] = {offsetof(gap_t, a), offsetof(gap_t, c)};
+
+    mu_check(cstruct_is_overlay("=BxH", gap_offsets, 2, sizeof(gap_t)));
+
+    gap_t   gap         = {0x01, 0x77, 0x0203};
+    uint8_t expected[8] = {0};
+    uint8_t actual[8]   = {0};
+
+    mu_assert_int_eq(
+        4, cstruct_pack_struct("=BxH", expected, sizeof(expected), &gap, gap_offsets, 2));
+    mu_assert_int_eq(0x00, expected[1]);
+
+    cstruct_jit_t *jit = cstruct_jit_compile("=BxH", gap_offsets, 2);
+    mu_assert_int_eq(4, cstruct_jit_pack(jit, actual, sizeof(actual), &gap));
+    mu_check(memcmp(expected, actual, sizeof(actual)) == 0);
+
+    gap_t unpacked = {0, 0x55, 0};
+    mu_assert_int_eq(4, cstruct_jit_unpack(jit, actual, 4, &unpacked));
+    mu_assert_int_eq(0x01, unpacked.a);
+    mu_assert_int_eq(0x55, unpacked.b);
+    mu_assert_int_eq(0x0203, unpacked.c);
+
+    cstruct_jit_free(jit);
+
+    // NOTE(Caleb): A typical native struct, with alignment padding under `@`, is overlaid too, and
+    // its padding is packed as zeroes whatever the struct holds
+    typedef struct
+    {
+        uint8_t  a;
+        uint32_t b;
+    } aligned_t;
+
+    static const size_t aligned_offsets[] = {offsetof(aligned_t, a), offsetof(aligned_t, b)};
+
+    aligned_t aligned;
+    memset(&aligned, 0xAA, sizeof(aligned));
+    aligned.a = 1;
+    aligned.b = 2;
+
+    mu_check(cstruct_is_overlay("@BI", aligned_offsets, 2, sizeof(aligned_t)));
+
+    jit = cstruct_jit_compile("@BI", aligned_offsets, 2);
+    cstruct_pack("@BI", expected, sizeof(expected), aligned.a, aligned.b);
+    mu_assert_int_eq(8, cstruct_jit_pack(jit, actual, sizeof(actual), &aligned));
+    mu_check(memcmp(expected, actual, sizeof(actual)) == 0);
+
+    // NOTE(Caleb): Unpacking leaves the struct's own padding alone, as well as unmapped members
+    aligned_t unpacked_aligned;
+    memset(&unpacked_aligned, 0xAA, sizeof(unpacked_aligned));
+
+    mu_assert_int_eq(8, cstruct_jit_unpack(jit, actual, 8, &unpacked_aligned));
+    mu_assert_int_eq(1, unpacked_aligned.a);
+    mu_assert_int_eq(2, unpacked_aligned.b);
+    mu_assert_int_eq(0xAA, ((uint8_t *)&unpacked_aligned)[1]);
+
+    cstruct_jit_free(jit);
+}
+
+MU_TEST(test_error_cases)
+{
+    uint8_t buffer[64] = {0};
+
+    // NOTE(Caleb): One offset too few, and one too many
+    mu_check(cstruct_jit_compile(RECORD_FORMAT, record_offsets, RECORD_OFFSET_COUNT - 1) == NULL);
+    mu_check(cstruct_jit_compile("!bHx2(H)2xiQ5sf", record_offsets, RECORD_OFFSET_COUNT) == NULL);
+    mu_check(cstruct_jit_compile("z", record_offsets, 1) == NULL);
+
+    mu_assert_int_eq(
+        -1, cstruct_pack_struct(
+                RECORD_FORMAT, buffer, sizeof(buffer), &record, record_offsets,
+                RECORD_OFFSET_COUNT - 1));
+
+    cstruct_jit_t *jit = cstruct_jit_compile(RECORD_FORMAT, record_offsets, RECORD_OFFSET_COUNT);
+    mu_assert_int_eq(-1, cstruct_jit_pack(jit, buffer, 38, &record));
+    cstruct_jit_free(jit);
+}
+
+MU_TEST_SUITE(test_suite)
+{
+    MU_RUN_TEST(test_matches_interpreter);
+    MU_RUN_TEST(test_struct_interpreter);
+    MU_RUN_TEST(test_fields);
+    MU_RUN_TEST(test_overlay);
+    MU_RUN_TEST(test_overlay_padding);
+    MU_RUN_TEST(test_error_cases);
+}
+
+int main(void)
+{
+    MU_RUN_SUITE(test_suite);
+    MU_REPORT();
+
+    return MU_EXIT_CODE;
+}
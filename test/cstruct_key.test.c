@@ -0,0 +1,192 @@
+#include "minunit.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cstruct.h"
+#include "cstruct_jit.h"
+
+MU_TEST(test_encoding)
+{
+    uint8_t buffer[32] = {0};
+
+    mu_assert_int_eq(1, cstruct_pack("^b", buffer, sizeof(buffer), -1));
+    mu_assert_int_eq(0x7F, buffer[0]);
+
+    mu_assert_int_eq(3, cstruct_pack("^hB", buffer, sizeof(buffer), 1, 0xFF));
+    mu_check(memcmp(buffer, (uint8_t[]) {0x80, 0x01, 0xFF}, 3) == 0);
+
+    // NOTE(Caleb): Positive floats have their sign bit set, and negative ones every bit flipped
+    mu_assert_int_eq(8, cstruct_pack("^ff", buffer, sizeof(buffer), 1.0f, -1.0f));
+    mu_check(memcmp(buffer, (uint8_t[]) {0xBF, 0x80, 0x00, 0x00, 0x40, 0x7F, 0xFF, 0xFF}, 8) == 0);
+
+    int8_t   b = 0;
+    uint16_t h = 0;
+    float    f = 0;
+    double   d = 0;
+    int64_t  q = 0;
+
+    cstruct_pack("^bHfdq", buffer, sizeof(buffer), -128, 0xBEEF, -0.5f, -1e300, INT64_MIN);
+    mu_assert_int_eq(23, cstruct_unpack("^bHfdq", buffer, sizeof(buffer), &b, &h, &f, &d, &q));
+    mu_assert_int_eq(-128, b);
+    mu_assert_int_eq(0xBEEF, h);
+    mu_assert_double_eq(-0.5, f);
+    mu_assert_double_eq(-1e300, d);
+    mu_check(q == INT64_MIN);
+}
+
+MU_TEST(test_sorts_with_memcmp)
+{
+    static const int32_t integers[] = {INT32_MIN, -70000, -1, 0, 1, 255, 256, 70000, INT32_MAX};
+    static const double  doubles[]  = {
+        -INFINITY, -1e300, -2.5, -1.0, -1e-300, -0.0, 0.0, 1e-300, 1.0, 2.5, 1e300, INFINITY,
+    };
+
+    uint8_t previous[8];
+    uint8_t current[8];
+
+    for (size_t i = 0; i < sizeof(integers) / sizeof(integers[0]); i++)
+    {
+        cstruct_pack("^i", current, sizeof(current), integers[i]);
+        mu_check(i == 0 || memcmp(previous, current, 4) < 0);
+        memcpy(previous, current, 4);
+    }
+
+    for (size_t i = 0; i < sizeof(doubles) / sizeof(doubles[0]); i++)
+    {
+        cstruct_pack("^d", current, sizeof(current), doubles[i]);
+        mu_check(i == 0 || memcmp(previous, current, 8) < 0);
+        memcpy(previous, current, 8);
+
+        double d = 0;
+        cstruct_unpack("^d", current, 8, &d);
+        mu_check(d == doubles[i] && signbit(d) == signbit(doubles[i]));
+    }
+}
+
+MU_TEST(test_structs)
+{
+    typedef struct
+    {
+        int16_t  h;
+        uint32_t id;
+        float    f;
+        int64_t  q;
+    } index_key_t;
+
+    static const size_t offsets[] = {
+        offsetof(index_key_t, h),
+        offsetof(index_key_t, id),
+        offsetof(index_key_t, f),
+        offsetof(index_key_t, q),
+    };
+
+    index_key_t key;
+    uint8_t     expected[18];
+    uint8_t     actual[18];
+
+    // NOTE(Caleb): Clear the padding before q, so that the whole struct can be compared
+    memset(&key, 0, sizeof(key));
+    key.h  = -300;
+    key.id = 7;
+    key.f  = -0.25f;
+    key.q  = -5;
+
+    cstruct_pack("^hIfq", expected, sizeof(expected), key.h, key.id, key.f, key.q);
+
+    mu_assert_int_eq(18, cstruct_pack_struct("^hIfq", actual, sizeof(actual), &key, offsets, 4));
+    mu_check(memcmp(expected, actual, sizeof(actual)) == 0);
+
+    index_key_t unpacked;
+    memset(&unpacked, 0, sizeof(unpacked));
+    mu_assert_int_eq(18, cstruct_unpack_struct("^hIfq", actual, 18, &unpacked, offsets, 4));
+    mu_check(memcmp(&key, &unpacked, sizeof(key)) == 0);
+
+    // NOTE(Caleb): Compiled formats, with and without floating point values, match the interpreter
+    static const char *formats[] = {"^hIfq", "^hI4xq"};
+
+    for (size_t k = 0; k < sizeof(formats) / sizeof(formats[0]); k++)
+    {
+        size_t offset_count  = k == 0 ? 4 : 3;
+        size_t jit_offsets[] = {offsets[0], offsets[1], offsets[k == 0 ? 2 : 3], offsets[3]};
+
+        cstruct_pack_struct(
+            formats[k], expected, sizeof(expected), &key, jit_offsets, offset_count);
+
+        cstruct_jit_t *jit = cstruct_jit_compile(formats[k], jit_offsets, offset_count);
+        mu_check(jit != NULL);
+
+        mu_assert_int_eq(18, cstruct_jit_pack(jit, actual, sizeof(actual), &key));
+        mu_check(memcmp(expected, actual, sizeof(actual)) == 0);
+
+        memset(&unpacked, 0, sizeof(unpacked));
+        mu_assert_int_eq(18, cstruct_jit_unpack(jit, actual, sizeof(actual), &unpacked));
+        mu_assert_int_eq(key.h, unpacked.h);
+        mu_check(unpacked.q == key.q);
+
+        cstruct_jit_free(jit);
+    }
+
+    mu_check(!cstruct_is_overlay("^hIfq", offsets, 4, sizeof(index_key_t)));
+    mu_assert_int_eq(-1, cstruct_swap_inplace("^hIfq", actual, sizeof(actual), 1));
+}
+
+MU_TEST(test_search)
+{
+    // NOTE(Caleb): Records sorted by a signed id, then by a float
+    static const struct
+    {
+        int16_t id;
+        float   f;
+    } sorted[] = {{-5, 0.0f}, {-1, -2.0f}, {-1, 3.0f}, {0, 1.0f}, {4, -1.0f}, {4, 0.5f}, {9, 0.0f}};
+
+    enum
+    {
+        COUNT = sizeof(sorted) / sizeof(sorted[0])
+    };
+
+    uint8_t records[COUNT * 6];
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        cstruct_pack("^hf", records + i * 6, 6, sorted[i].id, sorted[i].f);
+    }
+
+    uint8_t key[6];
+
+    cstruct_pack("^hf", key, sizeof(key), -1, 3.0f);
+    mu_assert_int_eq(2, cstruct_key_search("^hf", records, COUNT, key, 6));
+
+    cstruct_pack("^hf", key, sizeof(key), -1, 2.0f);
+    mu_assert_int_eq(2, cstruct_key_search("^hf", records, COUNT, key, 6));
+
+    // NOTE(Caleb): Searching by the leading field alone finds the first record with that id
+    cstruct_pack("^h", key, sizeof(key), 4);
+    mu_assert_int_eq(4, cstruct_key_search("^hf", records, COUNT, key, 2));
+
+    cstruct_pack("^h", key, sizeof(key), -32768);
+    mu_assert_int_eq(0, cstruct_key_search("^hf", records, COUNT, key, 2));
+
+    cstruct_pack("^h", key, sizeof(key), 10);
+    mu_assert_int_eq(COUNT, cstruct_key_search("^hf", records, COUNT, key, 2));
+
+    mu_assert_int_eq(0, cstruct_key_search("^hf", records, 0, key, 2));
+    mu_assert_int_eq(-1, cstruct_key_search("^hf", records, COUNT, key, 7));
+    mu_assert_int_eq(-1, cstruct_key_search("^h(f", records, COUNT, key, 2));
+}
+
+MU_TEST_SUITE(test_suite)
+{
+    MU_RUN_TEST(test_encoding);
+    MU_RUN_TEST(test_sorts_with_memcmp);
+    MU_RUN_TEST(test_structs);
+    MU_RUN_TEST(test_search);
+}
+
+int main(void)
+{
+    MU_RUN_SUITE(test_suite);
+    MU_REPORT();
+
+    return MU_EXIT_CODE;
+}
@@ -0,0 +1,281 @@
+#include "minunit.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cstruct.h"
+
+MU_TEST(test_round_trip)
+{
+    uint8_t buffer[64] = {0};
+
+    ssize_t packed_size = cstruct_pack(
+        "!bHiQfd3s", buffer, sizeof(buffer), -5, 0xBEEF, -70000, 42ULL, 1.5f, -0.25, "abc");
+    mu_assert_int_eq(30, packed_size);
+
+    const uint8_t expected_prefix[] = {0xFB, 0xBE, 0xEF, 0xFF, 0xFE, 0xEE, 0x90};
+    mu_check(memcmp(buffer, expected_prefix, sizeof(expected_prefix)) == 0);
+
+    int8_t   b = 0;
+    uint16_t h = 0;
+    int32_t  i = 0;
+    uint64_t q = 0;
+    float    f = 0;
+    double   d = 0;
+    char     s[3];
+
+    ssize_t unpacked_size =
+        cstruct_unpack("!bHiQfd3s", buffer, packed_size, &b, &h, &i, &q, &f, &d, s);
+    mu_assert_int_eq(30, unpacked_size);
+    mu_assert_int_eq(-5, b);
+    mu_assert_int_eq(0xBEEF, h);
+    mu_assert_int_eq(-70000, i);
+    mu_assert_int_eq(42, (int)q);
+    mu_assert_double_eq(1.5, f);
+    mu_assert_double_eq(-0.25, d);
+    mu_check(memcmp(s, "abc", 3) == 0);
+}
+
+MU_TEST(test_groups_round_trip)
+{
+    uint8_t buffer[64] = {0};
+    uint8_t flat[64]   = {0};
+
+    ssize_t packed_size =
+        cstruct_pack("<B2(Hf)x", buffer, sizeof(buffer), 9, 1, 1.0f, 2, 2.0f);
+    mu_assert_int_eq(14, packed_size);
+
+    // NOTE(Caleb): A group packs exactly the same bytes as its flat equivalent
+    ssize_t flat_size = cstruct_pack("<BHfHfx", flat, sizeof(flat), 9, 1, 1.0f, 2, 2.0f);
+    mu_assert_int_eq(packed_size, flat_size);
+    mu_check(memcmp(buffer, flat, flat_size) == 0);
+
+    uint8_t  header = 0;
+    uint16_t id[2]  = {0};
+    float    x[2]   = {0};
+
+    ssize_t unpacked_size = cstruct_unpack(
+        "<B2(Hf)x", buffer, packed_size, &header, &id[0], &x[0], &id[1], &x[1]);
+    mu_assert_int_eq(14, unpacked_size);
+    mu_assert_int_eq(9, header);
+    mu_assert_int_eq(1, id[0]);
+    mu_assert_int_eq(2, id[1]);
+    mu_assert_double_eq(1.0, x[0]);
+    mu_assert_double_eq(2.0, x[1]);
+}
+
+MU_TEST(test_nested_groups)
+{
+    uint8_t buffer[32] = {0};
+
+    ssize_t packed_size = cstruct_pack("!2(B2(H))", buffer, sizeof(buffer), 1, 2, 3, 4, 5, 6);
+    mu_assert_int_eq(10, packed_size);
+
+    const uint8_t expected[] = {0x01, 0x00, 0x02, 0x00, 0x03, 0x04, 0x00, 0x05, 0x00, 0x06};
+    mu_check(memcmp(buffer, expected, sizeof(expected)) == 0);
+}
+
+MU_TEST(test_native)
+{
+    struct
+    {
+        uint8_t a;
+        struct
+        {
+            uint8_t  b;
+            uint16_t h;
+        } groups[2];
+        double d;
+    } native, unpacked;
+
+    memset(&native, 0, sizeof(native));
+    native.a           = 1;
+    native.groups[0].b = 2;
+    native.groups[0].h = 0x0304;
+    native.groups[1].b = 5;
+    native.groups[1].h = 0x0607;
+    native.d           = -1.5;
+
+    uint8_t buffer[64];
+    memset(buffer, 0xAA, sizeof(buffer));
+
+    // NOTE(Caleb): Native alignment matches the compiler's layout, with padding packed as zeroes
+    ssize_t packed_size =
+        cstruct_pack("@B2(BH)d", buffer, sizeof(buffer), 1, 2, 0x0304, 5, 0x0607, -1.5);
+    mu_assert_int_eq(sizeof(native), packed_size);
+    mu_check(memcmp(buffer, &native, sizeof(native)) == 0);
+
+    memset(&unpacked, 0, sizeof(unpacked));
+    mu_assert_int_eq(
+        sizeof(native),
+        cstruct_unpack(
+            "@B2(BH)d", buffer, packed_size, &unpacked.a, &unpacked.groups[0].b,
+            &unpacked.groups[0].h, &unpacked.groups[1].b, &unpacked.groups[1].h, &unpacked.d));
+    mu_check(memcmp(&native, &unpacked, sizeof(native)) == 0);
+
+    // NOTE(Caleb): `=` packs in native byte order, without alignment
+    uint16_t h = 0x0102;
+    mu_assert_int_eq(3, cstruct_pack("=BH", buffer, sizeof(buffer), 9, h));
+    mu_check(memcmp(buffer + 1, &h, 2) == 0);
+
+    long l = -2;
+    long u = 0;
+    mu_assert_int_eq(sizeof(long), cstruct_pack("@l", buffer, sizeof(buffer), l));
+    mu_assert_int_eq(sizeof(long), cstruct_unpack("@l", buffer, sizeof(buffer), &u));
+    mu_check(l == u);
+}
+
+MU_TEST(test_long_formats)
+{
+    uint8_t buffer[64] = {0};
+
+    // NOTE(Caleb): Alternating values and padding can't be merged into longer runs, so this format
+    // string is decoded in more than one batch
+    ssize_t packed_size = cstruct_pack(
+        "!20(Bx)", buffer, sizeof(buffer), 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+        17, 18, 19, 20);
+    mu_assert_int_eq(40, packed_size);
+
+    for (int i = 0; i < 20; i++)
+    {
+        mu_assert_int_eq(i + 1, buffer[2 * i]);
+        mu_assert_int_eq(0, buffer[2 * i + 1]);
+    }
+
+    uint8_t b[20] = {0};
+
+    ssize_t unpacked_size = cstruct_unpack(
+        "!20(Bx)", buffer, packed_size, &b[0], &b[1], &b[2], &b[3], &b[4], &b[5], &b[6], &b[7],
+        &b[8], &b[9], &b[10], &b[11], &b[12], &b[13], &b[14], &b[15], &b[16], &b[17], &b[18],
+        &b[19]);
+    mu_assert_int_eq(40, unpacked_size);
+
+    for (int i = 0; i < 20; i++)
+    {
+        mu_assert_int_eq(i + 1, b[i]);
+    }
+
+    // NOTE(Caleb): A batch is checked against the buffer as a whole, before anything is packed
+    memset(buffer, 0xAA, sizeof(buffer));
+    mu_assert_int_eq(-1, cstruct_pack("!2H4Q", buffer, 20, 1, 2, 3ULL, 4ULL, 5ULL, 6ULL));
+    mu_assert_int_eq(0xAA, buffer[0]);
+}
+
+MU_TEST(test_large_runs)
+{
+    // NOTE(Caleb): Large enough to be written with non-temporal stores, and offset by a byte so
+    // that the run starts unaligned
+    const size_t size   = (40 << 20) + 3;
+    uint8_t     *source = malloc(size);
+    uint8_t     *buffer = malloc(size + 1);
+    uint8_t     *copy   = malloc(size);
+    char         format[64];
+
+    mu_check(source && buffer && copy);
+
+    for (size_t i = 0; i < size; i++)
+    {
+        source[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    snprintf(format, sizeof(format), "!B%zus", size);
+    mu_check(cstruct_pack(format, buffer, size + 1, 0xAB, source) == (ssize_t)size + 1);
+    mu_assert_int_eq(0xAB, buffer[0]);
+    mu_check(memcmp(buffer + 1, source, size) == 0);
+
+    uint8_t b = 0;
+    mu_check(cstruct_unpack(format, buffer, size + 1, &b, copy) == (ssize_t)size + 1);
+    mu_check(memcmp(copy, source, size) == 0);
+
+    snprintf(format, sizeof(format), "!B%zux", size);
+    mu_check(cstruct_pack(format, buffer, size + 1, 0xAB) == (ssize_t)size + 1);
+    mu_check(buffer[1] == 0 && buffer[size / 2] == 0 && buffer[size] == 0);
+
+    // NOTE(Caleb): Arrays of values are converted as a whole, both in cache sized chunks and, once
+    // they are large enough, with non-temporal stores
+    static const size_t counts[] = {1000, (5 << 20) - 1};
+
+    for (size_t k = 0; k < sizeof(counts) / sizeof(counts[0]); k++)
+    {
+        // NOTE(Caleb): Laid out like a struct with a tag byte, followed by an array of samples
+        size_t  count   = counts[k];
+        double *samples = (double *)(source + 8);
+        size_t *offsets = malloc((count + 1) * sizeof(size_t));
+
+        mu_check(offsets && 8 + count * sizeof(double) <= size);
+
+        source[0]  = 0x5A;
+        offsets[0] = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            samples[i]     = (double)i * 0.5 - 1000.0;
+            offsets[i + 1] = 8 + i * sizeof(double);
+        }
+
+        snprintf(format, sizeof(format), "!B%zud", count);
+        mu_check(
+            cstruct_pack_struct(format, buffer, size + 1, source, offsets, count + 1)
+            == (ssize_t)(1 + count * 8));
+        mu_assert_int_eq(0x5A, buffer[0]);
+
+        for (size_t i = 0; i < count; i += 4099)
+        {
+            double d = 0;
+            cstruct_unpack("!d", buffer + 1 + i * 8, 8, &d);
+            mu_check(d == samples[i]);
+        }
+
+        memset(copy, 0, 8 + count * sizeof(double));
+        mu_check(
+            cstruct_unpack_struct(format, buffer, size + 1, copy, offsets, count + 1)
+            == (ssize_t)(1 + count * 8));
+        mu_assert_int_eq(0x5A, copy[0]);
+        mu_check(memcmp(copy + 8, samples, count * sizeof(double)) == 0);
+
+        free(offsets);
+    }
+
+    free(source);
+    free(buffer);
+    free(copy);
+}
+
+MU_TEST(test_error_cases)
+{
+    uint8_t buffer[8] = {0};
+
+    mu_assert_int_eq(-1, cstruct_pack("", buffer, sizeof(buffer)));
+    mu_assert_int_eq(-1, cstruct_pack("z", buffer, sizeof(buffer), 0));
+    mu_assert_int_eq(-1, cstruct_pack("3I", buffer, sizeof(buffer), 1, 2, 3));
+    mu_assert_int_eq(-1, cstruct_pack("2(H", buffer, sizeof(buffer), 1, 2));
+    mu_assert_int_eq(-1, cstruct_pack("H)", buffer, sizeof(buffer), 1));
+
+    uint16_t h = 0;
+    mu_assert_int_eq(-1, cstruct_unpack("!2H", buffer, 3, &h, &h));
+    mu_assert_int_eq(-1, cstruct_unpack("!(H", buffer, sizeof(buffer), &h));
+
+    // NOTE(Caleb): Sizes which don't fit in a ssize_t are invalid
+    mu_assert_int_eq(-1, cstruct_pack("9223372036854775807x2x", buffer, sizeof(buffer)));
+    mu_assert_int_eq(-1, cstruct_pack("9223372036854775808x", buffer, sizeof(buffer)));
+}
+
+MU_TEST_SUITE(test_suite)
+{
+    MU_RUN_TEST(test_round_trip);
+    MU_RUN_TEST(test_groups_round_trip);
+    MU_RUN_TEST(test_nested_groups);
+    MU_RUN_TEST(test_native);
+    MU_RUN_TEST(test_long_formats);
+    MU_RUN_TEST(test_large_runs);
+    MU_RUN_TEST(test_error_cases);
+}
+
+int main(void)
+{
+    MU_RUN_SUITE(test_suite);
+    MU_REPORT();
+
+    return MU_EXIT_CODE;
+}
@@ -0,0 +1,191 @@
+#include "minunit.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "cstruct.h"
+#include "cstruct_ring.h"
+
+#define MESSAGE_FORMAT "!IHf"
+
+enum
+{
+    SLOT_COUNT       = 16,
+    SLOT_CAPACITY    = 32,
+    PRODUCER_COUNT   = 4,
+    MESSAGE_COUNT    = 10000,
+    STORAGE_CAPACITY = SLOT_COUNT * 64,
+};
+
+static _Alignas(CSTRUCT_RING_CACHE_LINE) unsigned char storage[STORAGE_CAPACITY];
+
+MU_TEST(test_storage_size)
+{
+    // NOTE(Caleb): A 16 byte header and 32 byte message fit within a single cache line
+    mu_assert_int_eq(STORAGE_CAPACITY, cstruct_ring_storage_size(SLOT_COUNT, SLOT_CAPACITY));
+    mu_assert_int_eq(128, cstruct_ring_storage_size(1, 100));
+
+    // NOTE(Caleb): Sizes which would wrap around are rejected, rather than coming out small
+    mu_check(cstruct_ring_storage_size(1, SIZE_MAX - 8) == 0);
+    mu_check(cstruct_ring_storage_size((size_t)1 << 62, 100) == 0);
+}
+
+MU_TEST(test_pack_unpack)
+{
+    cstruct_ring_t ring;
+    mu_assert_int_eq(
+        0, cstruct_ring_init(&ring, storage, sizeof(storage), SLOT_CAPACITY, CSTRUCT_RING_SPSC));
+    mu_assert_int_eq(SLOT_COUNT, ring.slot_count);
+
+    uint32_t id    = 0;
+    uint16_t kind  = 0;
+    float    value = 0;
+
+    // NOTE(Caleb): An empty ring has nothing to unpack
+    mu_assert_int_eq(0, cstruct_ring_unpack(&ring, MESSAGE_FORMAT, &id, &kind, &value));
+
+    mu_assert_int_eq(10, cstruct_ring_pack(&ring, MESSAGE_FORMAT, 1, 2, 3.0f));
+    mu_assert_int_eq(10, cstruct_ring_pack(&ring, MESSAGE_FORMAT, 4, 5, 6.0f));
+
+    mu_assert_int_eq(10, cstruct_ring_unpack(&ring, MESSAGE_FORMAT, &id, &kind, &value));
+    mu_assert_int_eq(1, id);
+    mu_assert_int_eq(2, kind);
+    mu_assert_double_eq(3.0, value);
+
+    mu_assert_int_eq(10, cstruct_ring_unpack(&ring, MESSAGE_FORMAT, &id, &kind, &value));
+    mu_assert_int_eq(4, id);
+    mu_assert_int_eq(5, kind);
+    mu_assert_double_eq(6.0, value);
+
+    mu_assert_int_eq(0, cstruct_ring_unpack(&ring, MESSAGE_FORMAT, &id, &kind, &value));
+}
+
+MU_TEST(test_full_ring)
+{
+    cstruct_ring_t ring;
+    cstruct_ring_init(&ring, storage, sizeof(storage), SLOT_CAPACITY, CSTRUCT_RING_SPSC);
+
+    for (int i = 0; i < SLOT_COUNT; i++)
+    {
+        mu_assert_int_eq(10, cstruct_ring_pack(&ring, MESSAGE_FORMAT, i, 0, 0.0f));
+    }
+
+    mu_check(cstruct_ring_reserve(&ring) == NULL);
+    mu_assert_int_eq(-1, cstruct_ring_pack(&ring, MESSAGE_FORMAT, 0, 0, 0.0f));
+
+    size_t      length = 0;
+    const void *slot   = cstruct_ring_peek(&ring, &length);
+    mu_check(slot != NULL);
+    mu_assert_int_eq(10, length);
+    cstruct_ring_release(&ring);
+
+    mu_check(cstruct_ring_reserve(&ring) != NULL);
+}
+
+MU_TEST(test_failed_pack_is_skipped)
+{
+    cstruct_ring_t ring;
+    cstruct_ring_init(&ring, storage, sizeof(storage), SLOT_CAPACITY, CSTRUCT_RING_SPSC);
+
+    // NOTE(Caleb): Packing more than a slot can hold fails, but must not stall the consumer
+    mu_assert_int_eq(-1, cstruct_ring_pack(&ring, "40B", 0));
+    mu_assert_int_eq(10, cstruct_ring_pack(&ring, MESSAGE_FORMAT, 7, 8, 9.0f));
+
+    uint32_t id    = 0;
+    uint16_t kind  = 0;
+    float    value = 0;
+
+    mu_assert_int_eq(10, cstruct_ring_unpack(&ring, MESSAGE_FORMAT, &id, &kind, &value));
+    mu_assert_int_eq(7, id);
+}
+
+MU_TEST(test_init_errors)
+{
+    cstruct_ring_t ring;
+
+    mu_assert_int_eq(-1, cstruct_ring_init(&ring, NULL, 64, 8, CSTRUCT_RING_SPSC));
+    mu_assert_int_eq(-1, cstruct_ring_init(&ring, storage + 1, 64, 8, CSTRUCT_RING_SPSC));
+    mu_assert_int_eq(-1, cstruct_ring_init(&ring, storage, 32, 8, CSTRUCT_RING_SPSC));
+    mu_assert_int_eq(-1, cstruct_ring_init(&ring, storage, 64, 0, CSTRUCT_RING_SPSC));
+    mu_assert_int_eq(-1, cstruct_ring_init(&ring, storage, 64, SIZE_MAX - 8, CSTRUCT_RING_SPSC));
+}
+
+/// Pack MESSAGE_COUNT messages into the ring, tagged with the producer's index.
+static void *producer(void *arg)
+{
+    cstruct_ring_t *ring  = arg;
+    static int      next  = 0;
+    int             index = __atomic_fetch_add(&next, 1, __ATOMIC_RELAXED);
+
+    for (int i = 0; i < MESSAGE_COUNT; i++)
+    {
+        while (cstruct_ring_pack(ring, MESSAGE_FORMAT, i, index, 0.0f) < 0)
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+MU_TEST(test_multiple_producers)
+{
+    cstruct_ring_t ring;
+    cstruct_ring_init(&ring, storage, sizeof(storage), SLOT_CAPACITY, CSTRUCT_RING_MPSC);
+
+    pthread_t producers[PRODUCER_COUNT];
+    for (int i = 0; i < PRODUCER_COUNT; i++)
+    {
+        pthread_create(&producers[i], NULL, producer, &ring);
+    }
+
+    // NOTE(Caleb): Messages from each producer must arrive complete and in order
+    uint32_t expected[PRODUCER_COUNT] = {0};
+    int      received                 = 0;
+    int      out_of_order             = 0;
+
+    while (received < PRODUCER_COUNT * MESSAGE_COUNT)
+    {
+        uint32_t id    = 0;
+        uint16_t index = 0;
+        float    value = 0;
+
+        if (cstruct_ring_unpack(&ring, MESSAGE_FORMAT, &id, &index, &value) > 0)
+        {
+            out_of_order += index >= PRODUCER_COUNT || id != expected[index]++;
+            received++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    for (int i = 0; i < PRODUCER_COUNT; i++)
+    {
+        pthread_join(producers[i], NULL);
+    }
+
+    mu_assert_int_eq(0, out_of_order);
+    mu_check(cstruct_ring_peek(&ring, NULL) == NULL);
+}
+
+MU_TEST_SUITE(test_suite)
+{
+    MU_RUN_TEST(test_storage_size);
+    MU_RUN_TEST(test_pack_unpack);
+    MU_RUN_TEST(test_full_ring);
+    MU_RUN_TEST(test_failed_pack_is_skipped);
+    MU_RUN_TEST(test_init_errors);
+    MU_RUN_TEST(test_multiple_producers);
+}
+
+int main(void)
+{
+    MU_RUN_SUITE(test_suite);
+    MU_REPORT();
+
+    return MU_EXIT_CODE;
+}
@@ -1,5 +1,7 @@
 #include "minunit.h"
 
+#include <stdint.h>
+
 #include "cstruct.h"
 
 MU_TEST(test_basic_format_chars)
@@ -33,6 +35,19 @@ MU_TEST(test_byte_order_specifiers)
     mu_assert_int_eq(cstruct_sizeof("q"), cstruct_sizeof("<q"));
     mu_assert_int_eq(cstruct_sizeof("q"), cstruct_sizeof(">q"));
     mu_assert_int_eq(cstruct_sizeof("q"), cstruct_sizeof("!q"));
+
+    const uint16_t probe = 1;
+    const bool     host  = *(const uint8_t *)&probe == 1;
+
+    mu_check(cstruct_is_little_endian("<h"));
+    mu_check(!cstruct_is_little_endian(">h"));
+    mu_check(!cstruct_is_little_endian("!h"));
+    mu_check(!cstruct_is_little_endian("^h"));
+    mu_check(!cstruct_is_little_endian("h"));
+    mu_check(cstruct_is_little_endian("@h") == host);
+    mu_check(cstruct_is_little_endian("=h") == host);
+    mu_check(!cstruct_is_little_endian(NULL));
+    mu_check(!cstruct_is_little_endian(""));
 }
 
 MU_TEST(test_repeat_counts)
@@ -62,6 +77,39 @@ MU_TEST(test_combined_with_byte_order)
     mu_assert_int_eq(13, cstruct_sizeof("<b2xif2s"));
 }
 
+MU_TEST(test_groups)
+{
+    mu_assert_int_eq(10, cstruct_sizeof("(Hff)"));        // 2 + 4 + 4
+    mu_assert_int_eq(1000, cstruct_sizeof("100(Hff)"));   // 100 * (2 + 4 + 4)
+    mu_assert_int_eq(1003, cstruct_sizeof("!B100(Hff)H")); // 1 + 1000 + 2
+    mu_assert_int_eq(16, cstruct_sizeof("2(B3(H)x)"));    // 2 * (1 + 3 * 2 + 1)
+    mu_assert_int_eq(48, cstruct_sizeof("2(2(2(3h)))"));  // 2 * 2 * 2 * 3 * 2
+    mu_assert_int_eq(cstruct_sizeof("HffHff"), cstruct_sizeof("2(Hff)"));
+}
+
+MU_TEST(test_native)
+{
+    // NOTE(Caleb): `=` uses standard sizes and no alignment, while `@` aligns every value
+    mu_assert_int_eq(7, cstruct_sizeof("=BHi"));
+    mu_assert_int_eq(8, cstruct_sizeof("@BHi"));     // B, 1 pad, H, i
+    mu_assert_int_eq(16, cstruct_sizeof("@Bd"));     // B, 7 pad, d
+    mu_assert_int_eq(9, cstruct_sizeof("@dB"));      // No trailing padding
+    mu_assert_int_eq(16, cstruct_sizeof("@2(BI)"));  // Each iteration is padded to 8 bytes
+    mu_assert_int_eq(10, cstruct_sizeof("@B2(BH)")); // B, 1 pad, then 2 iterations of 4 bytes
+    mu_assert_int_eq((ssize_t)sizeof(long), cstruct_sizeof("@l"));
+    mu_assert_int_eq(4, cstruct_sizeof("=l"));
+
+    struct
+    {
+        uint8_t  a;
+        uint32_t b;
+        uint16_t c[3];
+        double   d;
+    } native;
+
+    mu_assert_int_eq(sizeof(native), cstruct_sizeof("@BI3Hd"));
+}
+
 MU_TEST(test_error_cases)
 {
     mu_assert_int_eq(-1, cstruct_sizeof(""));            // Empty string
@@ -71,8 +119,18 @@ MU_TEST(test_error_cases)
     mu_assert_int_eq(-1, cstruct_sizeof("<>h"));         // Multiple byte order specifiers
     mu_assert_int_eq(-1, cstruct_sizeof("<<h"));         // Repeated byte order specifier
     mu_assert_int_eq(-1, cstruct_sizeof("h<i"));         // Byte order in middle
-    mu_assert_int_eq(-1, cstruct_sizeof("4294967296h")); // Multiplier overflow
-    mu_assert_int_eq(-1, cstruct_sizeof("@h"));          // Invalid byte order specifier
+    mu_assert_int_eq(-1, cstruct_sizeof("?h"));          // Invalid byte order specifier
+    mu_assert_int_eq(-1, cstruct_sizeof("2(Hff"));       // Unclosed group
+    mu_assert_int_eq(-1, cstruct_sizeof("Hff)"));        // Unopened group
+    mu_assert_int_eq(-1, cstruct_sizeof("2()"));         // Empty group
+    mu_assert_int_eq(-1, cstruct_sizeof("0(h)"));        // Zero group multiplier
+    mu_assert_int_eq(-1, cstruct_sizeof("2(hz)"));       // Invalid format character in group
+    mu_assert_int_eq(-1, cstruct_sizeof("(((((((((h)))))))))")); // Groups nested too deeply
+
+    mu_assert_int_eq(-1, cstruct_sizeof("9223372036854775808h"));    // Multiplier overflow
+    mu_assert_int_eq(-1, cstruct_sizeof("4611686018427387904h"));    // Size overflow
+    mu_assert_int_eq(-1, cstruct_sizeof("9223372036854775807xB"));   // Total size overflow
+    mu_assert_int_eq(-1, cstruct_sizeof("2(4611686018427387904B)")); // Group size overflow
 }
 
 MU_TEST(test_edge_cases)
@@ -82,6 +140,12 @@ MU_TEST(test_edge_cases)
     mu_assert_int_eq(4000, cstruct_sizeof("1000i"));
     mu_assert_int_eq(8000, cstruct_sizeof("1000q"));
     mu_assert_int_eq(10000, cstruct_sizeof("10000x"));
+
+    // NOTE(Caleb): Sizes are 64-bit, so runs and groups may go well past 4 GiB
+    mu_check(cstruct_sizeof("4294967296h") == 8589934592LL);
+    mu_check(cstruct_sizeof("3000000000B") == 3000000000LL);
+    mu_check(cstruct_sizeof("3(1000000000d)") == 24000000000LL);
+    mu_check(cstruct_sizeof("9223372036854775807x") == INT64_MAX);
 }
 
 MU_TEST_SUITE(test_suite)
@@ -91,6 +155,8 @@ MU_TEST_SUITE(test_suite)
     MU_RUN_TEST(test_repeat_counts);
     MU_RUN_TEST(test_combined_formats);
     MU_RUN_TEST(test_combined_with_byte_order);
+    MU_RUN_TEST(test_groups);
+    MU_RUN_TEST(test_native);
     MU_RUN_TEST(test_error_cases);
     MU_RUN_TEST(test_edge_cases);
 }
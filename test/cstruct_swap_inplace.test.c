@@ -0,0 +1,135 @@
+#include "minunit.h"
+
+#include <stdint.h>
+
+#include "cstruct.h"
+
+/// Return true if the host is little-endian, and false otherwise.
+static int host_is_little_endian(void)
+{
+    const uint16_t x = 1;
+    return *(const uint8_t *)&x == 1;
+}
+
+MU_TEST(test_single_record)
+{
+    // NOTE(Caleb): B, H, I, Q, 4s in big-endian order
+    uint8_t buffer[] = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A,
+        0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13,
+    };
+
+    mu_assert_int_eq(19, cstruct_swap_inplace("!BHIQ4s", buffer, sizeof(buffer), 1));
+
+    if (host_is_little_endian())
+    {
+        const uint8_t expected[] = {
+            0x01, 0x03, 0x02, 0x07, 0x06, 0x05, 0x04, 0x0F, 0x0E, 0x0D,
+            0x0C, 0x0B, 0x0A, 0x09, 0x08, 0x10, 0x11, 0x12, 0x13,
+        };
+        mu_check(memcmp(buffer, expected, sizeof(buffer)) == 0);
+    }
+
+    uint16_t h = 0;
+    uint32_t u = 0;
+    memcpy(&h, buffer + 1, 2);
+    memcpy(&u, buffer + 3, 4);
+    mu_assert_int_eq(0x0203, h);
+    mu_assert_int_eq(0x04050607, u);
+}
+
+MU_TEST(test_matches_unpack)
+{
+    uint8_t buffer[64] = {0};
+
+    ssize_t size =
+        cstruct_pack(">hbif2dx", buffer, sizeof(buffer), -2, 7, -123456, 1.5f, 2.25, -8.0);
+    mu_assert_int_eq(28, size);
+
+    mu_assert_int_eq(28, cstruct_swap_inplace(">hbif2dx", buffer, sizeof(buffer), 1));
+
+    int16_t h = 0;
+    int32_t i = 0;
+    float   f = 0;
+    double  d = 0;
+    memcpy(&h, buffer, 2);
+    memcpy(&i, buffer + 3, 4);
+    memcpy(&f, buffer + 7, 4);
+    memcpy(&d, buffer + 19, 8);
+
+    mu_assert_int_eq(-2, h);
+    mu_assert_int_eq(7, buffer[2]);
+    mu_assert_int_eq(-123456, i);
+    mu_assert_double_eq(1.5, f);
+    mu_assert_double_eq(-8.0, d);
+}
+
+MU_TEST(test_many_records_round_trip)
+{
+    enum
+    {
+        RECORD_COUNT = 3000,
+    };
+
+    static uint8_t buffer[RECORD_COUNT * 11];
+    static uint8_t original[RECORD_COUNT * 11];
+
+    for (size_t j = 0; j < RECORD_COUNT; j++)
+    {
+        cstruct_pack(
+            "<HIBi", buffer + j * 11, 11, (int)j, (int)(j * 7919), (int)(j & 0xFF), -(int)j);
+    }
+    memcpy(original, buffer, sizeof(buffer));
+
+    ssize_t size = sizeof(buffer);
+    mu_assert_int_eq(size, cstruct_swap_inplace("<HIBi", buffer, sizeof(buffer), RECORD_COUNT));
+    mu_assert_int_eq(size, cstruct_swap_inplace("<HIBi", buffer, sizeof(buffer), RECORD_COUNT));
+    mu_check(memcmp(buffer, original, sizeof(buffer)) == 0);
+}
+
+MU_TEST(test_uniform_records)
+{
+    uint32_t values[100];
+    for (uint32_t j = 0; j < 100; j++)
+    {
+        cstruct_pack("!I", &values[j], 4, j * 0x01010101u + 0x00010203u);
+    }
+
+    // NOTE(Caleb): After conversion, each value is in host order regardless of the host
+    mu_assert_int_eq(400, cstruct_swap_inplace("!2I", values, sizeof(values), 50));
+
+    for (uint32_t j = 0; j < 100; j++)
+    {
+        mu_assert_int_eq(j * 0x01010101u + 0x00010203u, values[j]);
+    }
+}
+
+MU_TEST(test_error_cases)
+{
+    uint8_t buffer[8] = {0};
+
+    mu_assert_int_eq(-1, cstruct_swap_inplace("", buffer, sizeof(buffer), 1));
+    mu_assert_int_eq(-1, cstruct_swap_inplace("Hz", buffer, sizeof(buffer), 1));
+    mu_assert_int_eq(-1, cstruct_swap_inplace("!Q", NULL, sizeof(buffer), 1));
+    mu_assert_int_eq(-1, cstruct_swap_inplace("!Q", buffer, sizeof(buffer), 2));
+    mu_assert_int_eq(-1, cstruct_swap_inplace("!I", buffer, 3, 1));
+
+    mu_assert_int_eq(0, cstruct_swap_inplace("!Q", buffer, sizeof(buffer), 0));
+}
+
+MU_TEST_SUITE(test_suite)
+{
+    MU_RUN_TEST(test_single_record);
+    MU_RUN_TEST(test_matches_unpack);
+    MU_RUN_TEST(test_many_records_round_trip);
+    MU_RUN_TEST(test_uniform_records);
+    MU_RUN_TEST(test_error_cases);
+}
+
+int main(void)
+{
+    MU_RUN_SUITE(test_suite);
+    MU_REPORT();
+
+    return MU_EXIT_CODE;
+}